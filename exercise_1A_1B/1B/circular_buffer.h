@@ -15,6 +15,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <ctype.h>
 #include <getopt.h>
 #include <time.h>
 #include <sys/mman.h>
@@ -27,14 +28,49 @@
 
 
 /**
- * @brief defining constants for the size of the buffer, shared memory name ans semaphore names
+ * @brief defining constants for the size of the buffer, shared memory name ans semaphore names;
+ *        the names are only the prefix/suffixes, the actual names also contain the (optional) instance name
  * 
  */
 #define BUFFER_SIZE (20)
-#define SHM_NAME "/12122096_SHM"
-#define SEM_FREE_NAME "/12122096_FREE"
-#define SEM_USED_NAME "/12122096_USED"
-#define SEM_BLOCKED_NAME "/12122096_BLOCKED"
+#define IPC_PREFIX "/12122096"
+#define SHM_NAME "_SHM"
+#define SEM_FREE_NAME "_FREE"
+#define SEM_USED_NAME "_USED"
+#define SEM_BLOCKED_NAME "_BLOCKED"
+
+/**
+ * @brief max length of an instance name and of the resulting names of shm and semaphores
+ *
+ */
+#define INSTANCE_NAME_MAX (32)
+#define IPC_NAME_MAX (64)
+
+/**
+ * @brief max number of edges of a graph which gets passed to the generators through the shared memory
+ *
+ */
+#define MAX_EDGES (4096)
+
+/**
+ * @brief max weight of an edge; the cost of a feedback arc set (sum of at most MAX_EDGES weights) always fits into an
+ *        uint64_t
+ *
+ */
+#define MAX_WEIGHT (UINT64_MAX / MAX_EDGES)
+
+/**
+ * @brief max number of vertices for the exact mode of the generator (vertices are stored as bits of an uint32_t)
+ *
+ */
+#define EXACT_MAX_VERTICES (32)
+
+/**
+ * @brief exit code of a generator in exact mode whose minimal feedback arc set has more than 8 edges (so that it does
+ *        not fit into the circular buffer); the number of edges gets stored in exact_edges of the circular buffer
+ *
+ */
+#define EXACT_TOO_MANY_EDGES (3)
 
 /**
  * @brief init instances of circ_buffer, semaphores and shm
@@ -46,6 +82,50 @@ sem_t *used_sem = NULL;
 sem_t *blocked_sem = NULL;
 int shm_fd = 0;
 
+/**
+ * @brief names of shm and semaphores of the current instance; get built up by init_ipc_names()
+ *
+ */
+char shm_name[IPC_NAME_MAX];
+char sem_free_name[IPC_NAME_MAX];
+char sem_used_name[IPC_NAME_MAX];
+char sem_blocked_name[IPC_NAME_MAX];
+
+/**
+ * @brief builds up the names of shm and semaphores based on the given instance name;
+ *        without instance name (NULL) the names are the same as before (e.g. "/12122096_SHM"), otherwise the
+ *        instance name gets inserted (e.g. "/12122096_graph1_SHM") so that several instances can run on one host
+ *
+ * @param instance the instance name or NULL
+ * @return true if the instance name is valid (only alphanumeric chars, '-' and '_' and not too long)
+ * @return false if the instance name is not valid
+ */
+static bool init_ipc_names(const char *instance)
+{
+    char infix[INSTANCE_NAME_MAX + 2] = "";
+
+    if (instance != NULL)
+    {
+        size_t length = strlen(instance);
+        if (length == 0 || length > INSTANCE_NAME_MAX)
+            return false;
+
+        for (size_t i = 0; i < length; i++)
+        {
+            if (!isalnum((unsigned char)instance[i]) && instance[i] != '-' && instance[i] != '_')
+                return false;
+        }
+        snprintf(infix, sizeof(infix), "_%s", instance);
+    }
+
+    snprintf(shm_name, IPC_NAME_MAX, "%s%s%s", IPC_PREFIX, infix, SHM_NAME);
+    snprintf(sem_free_name, IPC_NAME_MAX, "%s%s%s", IPC_PREFIX, infix, SEM_FREE_NAME);
+    snprintf(sem_used_name, IPC_NAME_MAX, "%s%s%s", IPC_PREFIX, infix, SEM_USED_NAME);
+    snprintf(sem_blocked_name, IPC_NAME_MAX, "%s%s%s", IPC_PREFIX, infix, SEM_BLOCKED_NAME);
+
+    return true;
+}
+
 
 /**
  * @brief defines a struct with one edge with two vertices 'u' and 'v'
@@ -58,24 +138,231 @@ struct edge
 };
 
 /**
- * @brief defines a struct with 8 edges of the feedback arc set and the number of edges of the current fb arc set
+ * @brief defines a struct with 8 edges of the feedback arc set, the number of edges and the total cost (sum of the
+ *        weights of all edges) of the current fb arc set;
+ *        optimal is true if the fb arc set is known to be minimal (written by a generator in exact mode)
  *
  */
 struct element
 {
     int edge_number;
+    uint64_t cost;
+    bool optimal;
     struct edge fb_arc_set[8];
 };
 
+/**
+ * @brief defines a struct of the graph which gets passed to the generators (which are started by the supervisor)
+ *        through the shared memory; number_edges is zero if the generators get the edges through their arguments;
+ *        every edge consists of the vertices 'u' and 'v' and its weight; weighted is true if at least one edge has an
+ *        explicit weight (then the supervisor prints the cost of the solutions)
+ *
+ */
+struct graph
+{
+    int number_edges;
+    int max_vertex;
+    bool weighted;
+    long edge[MAX_EDGES][3];
+};
+
+/**
+ * @brief defines a struct which describes the generator which is currently writing to the circular buffer;
+ *        is needed by the supervisor to release the semaphores if this generator crashes while writing;
+ *        stage: 1 = holds blocked_sem, 2 = additionally holds a free slot, 3 = element is written (wr_pos moved)
+ *
+ */
+struct writer
+{
+    pid_t pid;
+    int stage;
+};
+
 /**
  * @brief defines a struct of the circular buffer;
  *        the state bool notifies all generators to terminate (before the supervisore terminates);
- *        the writing position tells the generator(s) where to write on the circular buffer
+ *        the writing position tells the generator(s) where to write on the circular buffer;
+ *        best_cost is the cost of the best solution of the supervisor (upper bound for exact mode);
+ *        the writer describes the generator which is currently writing;
+ *        exact_edges is the number of edges of a minimal solution which does not fit into the circular buffer;
+ *        the graph is used by generators which are started without edges
  *
  */
 struct circ_buffer
 {
     bool state;
     int wr_pos;
+    uint64_t best_cost;
+    int exact_edges;
+    struct writer writer;
     struct element buffer[BUFFER_SIZE];
+    struct graph graph;
 };
+
+/**
+ * @brief stores edges based on given input graph into array and checks if all edges are valid;
+ *        also returns the highest numeric value of all vertices;
+ *
+ * @param input given input graph, where every char is a single element of array
+ * @param number_edges counted number of edges in input; is needed for edge-array
+ * @param edge two-dimensional array where all edges are stored (vertex u, vertex v, weight)
+ * @param weighted is set to true if at least one edge has an explicit weight
+ * @param argv simple hand over of program name argv[0] for error messages
+ * @return int max value (index) of vertices
+ */
+static int create_edges(char *input, int number_edges, long edge[number_edges][3], bool *weighted, char *argv[])
+{
+    // stores rest of the string
+    char *full_rest = NULL;
+
+    // get the first edge (example: 1-2)
+    char *full_edge_token = strtok_r(input, " ", &full_rest);
+
+    int counter = 0;
+    int max_vertex_value = 0;
+
+    char *end_char;
+    *weighted = false;
+
+    // loop as long as edges are in the rest of the string
+    while (full_edge_token != NULL)
+    {
+        // stores rest of the string
+        char *single_rest = NULL;
+
+        // get first vertex of edge
+        char *single_edge_token = strtok_r(full_edge_token, "-", &single_rest);
+        char *first = single_edge_token;
+
+        // convert current first vertex from string to long
+        long first_value = strtol(first, &end_char, 10);
+
+        // check if current (first) vertex of edge has the highest value (index) of all vertices
+        if (first_value > max_vertex_value)
+            max_vertex_value = first_value;
+
+        // pass NULL to continue splitting string with strtok_r and get second vertex of edge
+        char *second = single_edge_token = strtok_r(NULL, " ", &single_rest);
+
+        // convert current second vertex from string to long
+        long second_value = strtol(second, &end_char, 10);
+
+        // check if current (second) vertex of edge has the highest value (index) of all vertices
+        if (second_value > max_vertex_value)
+            max_vertex_value = second_value;
+
+        // optional weight of edge (example: 1-2:5); default weight is 1
+        long weight = 1;
+        if (*end_char == ':')
+        {
+            char *weight_start = end_char + 1;
+            errno = 0;
+            weight = strtol(weight_start, &end_char, 10);
+
+            // nothing after the weight is allowed (example: 1-2:5abc)
+            if (end_char == weight_start || *end_char != '\0')
+            {
+                fprintf(stderr, "%s Invalid Edge! Invalid weight of an edge!\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            if (weight < 1)
+            {
+                fprintf(stderr, "%s Invalid Edge! The weight of an edge has to be positive!\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            if (errno == ERANGE || (uint64_t)weight > MAX_WEIGHT)
+            {
+                fprintf(stderr, "%s Invalid Edge! The weight of an edge must not be greater than %llu!\n", argv[0],
+                        (unsigned long long)MAX_WEIGHT);
+                exit(EXIT_FAILURE);
+            }
+            *weighted = true;
+        }
+
+        // check if vertex is connected to itself --> not allowed
+        if (first_value == second_value)
+        {
+            fprintf(stderr, "%s Invalid Edge! At least one vertex is connected to itself!\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+
+        // check if same edge already exists; without this for-loop code works perfectly fine too, but duplicates of
+        // edges get saved in edge-array too --> doesn't matter but is maybe inefficient
+        for (int i = 0; i < counter; i++)
+        {
+            if (first_value == edge[i][0] && second_value == edge[i][1])
+            {
+                fprintf(stderr, "%s Invalid Edge! At least one edge already exists!\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        // store vertices of edges in array
+        edge[counter][0] = first_value;
+        edge[counter][1] = second_value;
+        edge[counter++][2] = weight;
+
+        // pass NULL to continue splitting string with strtok_r and get other edges
+        full_edge_token = strtok_r(NULL, " ", &full_rest);
+    }
+
+    return max_vertex_value;
+}
+
+/**
+ * @brief builds up one string of all given edges which are separated by whitespaces;
+ *        the string gets splitted again in create_edges
+ *
+ * @param count the number of given edges
+ * @param edges the given edges (e.g. "1-2")
+ * @param argv simple hand over of program name argv[0] for error messages
+ * @return char* the allocated string which needs to be freed
+ */
+static char *join_edges(int count, char *edges[], char *argv[])
+{
+    size_t length = 0;
+
+    // count number of chars in all given arguments
+    for (int i = 0; i < count; i++)
+    {
+        length += strlen(edges[i]);
+    }
+
+    // add number of whitespaces which are needed between edges to length (+ 1 because of \0)
+    length += count;
+
+    char *input = malloc(length);
+    if (input == NULL)
+    {
+        fprintf(stderr, "%s Error while allocating memory: %s\n", argv[0], strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    strcpy(input, edges[0]);
+    for (int i = 1; i < count; i++)
+    {
+        strcat(input, " ");
+        strcat(input, edges[i]);
+    }
+
+    return input;
+}
+
+/**
+ * @brief counts the occurrence of '-' (and therefore the number of edges) in the given input
+ *
+ * @param input the string of all edges
+ * @return int the number of edges
+ */
+static int count_edges(const char *input)
+{
+    int number_edges = 0;
+
+    for (int i = 0; input[i] != '\0'; i++)
+    {
+        if (input[i] == '-')
+            number_edges++;
+    }
+
+    return number_edges;
+}
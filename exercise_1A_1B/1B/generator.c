@@ -9,6 +9,12 @@
 
 #include "circular_buffer.h"
 
+/**
+ * @brief number of bits of the index into the cache of the exact mode
+ *
+ */
+#define EXACT_CACHE_BITS (20)
+
 /**
  * @brief Function to handle signals;
  *        In this case 'state' in circular_buffer will be set to false if signal gets detected
@@ -72,163 +78,663 @@ static void cleanup_shm_sem(int cleanup_state, int exit_code, char *argv[])
 }
 
 /**
- * @brief stores edges based on given input graph into array and checks if all edges are valid;
- *        also returns the highest numeric value of all vertices;
+ * @brief shuffles vertices-array using the Fisher-Yates shuffle
  *
- * @param input given input graph, where every char is a single element of array
+ * @param vertices array where all vertices are stored in ascending order
+ * @param max_index max value (index) of vertices
+ */
+static void shuffle(int vertices[], int max_index)
+{
+    int i, j, temp;
+
+    // call rand one time before usage to fix pseudo random effect (often same numbers when first called)
+    rand();
+
+    for (i = max_index; i > 0; i--)
+    {
+        j = rand() % (max_index + 1);
+
+        // shuffle values
+        temp = vertices[j];
+        vertices[j] = vertices[i];
+        vertices[i] = temp;
+    }
+}
+
+/**
+ * @brief checks if vertices of edge are in topological order based on their index
+ *
+ * @param value_1 first vertex 'u' of edge
+ * @param value_2 second vertex 'v' of edge
+ * @param position array where the index of every vertex in the vertices-array is stored
+ * @return true if vertices are in topological order
+ * @return false if vertices are not in topological order
+ */
+static bool inOrder(long value_1, long value_2, int position[])
+{
+    // check if values are in topological order
+    return position[value_1] < position[value_2];
+}
+
+/**
+ * @brief finds feedback arc set of given vertices-array and edge-array; the cost of the feedback arc set (sum of
+ *        the weights of all its edges) gets computed in the same loop
+ *
+ * @param vertices array where all vertices are stored
+ * @param position array where the index of every vertex in the vertices-array gets stored
  * @param number_edges counted number of edges in input; is needed for edge-array
- * @param edge two-dimensional array where all edges are stored
- * @param argv simple hand over of program name argv[0] for error messages
- * @return int max value (index) of vertices
+ * @param edge two-dimensional array where all edges are stored (vertex u, vertex v, weight)
+ * @param max_index max value (index) of vertices
+ * @param fb_arc_set empty fb_arc_set-array where the first 8 edges of the solution are getting stored
+ * @param cost the cost of the feedback arc set gets stored here
+ * @return int the number of edges in the feedback arc set (can be greater than 8)
+ */
+static int find_fb_arc_set(int vertices[], int position[], int number_edges, long edge[number_edges][3], int max_index,
+                           long fb_arc_set[8][2], uint64_t *cost)
+{
+    // init fb_counter and cost
+    int fb_counter = 0;
+    uint64_t fb_cost = 0;
+
+    // index of every vertex, so that the order of an edge can be checked in constant time
+    for (int i = 0; i < max_index + 1; i++)
+    {
+        position[vertices[i]] = i;
+    }
+
+    // add all edges which are not in order to fb arc set and increment fb_counter
+    for (int i = 0; i < number_edges; i++)
+    {
+        if (!inOrder(edge[i][0], edge[i][1], position))
+        {
+            if (fb_counter < 8)
+            {
+                fb_arc_set[fb_counter][0] = edge[i][0];
+                fb_arc_set[fb_counter][1] = edge[i][1];
+            }
+            fb_counter++;
+            fb_cost += edge[i][2];
+        }
+    }
+
+    *cost = fb_cost;
+    return fb_counter;
+}
+
+/**
+ * @brief state of the greedy ordering; degrees of the remaining vertices and the doubly linked lists of sinks,
+ *        sources and the vertices grouped by the difference of out-degree and in-degree;
+ *        for a weighted graph the differences of the sums of the weights are too large for lists, so all other
+ *        vertices are in list 2 (which is never used by an unweighted graph) and additionally in a max-heap ordered
+ *        by the difference of out-weight and in-weight
+ *
+ */
+struct greedy
+{
+    int vertices;
+    int max_list;
+    int *out_degree;
+    int *in_degree;
+    int *list;
+    int *next;
+    int *prev;
+    int *head;
+    bool weighted;
+    uint64_t *out_weight;
+    uint64_t *in_weight;
+    int *heap;
+    int *heap_position;
+    int heap_size;
+};
+
+/**
+ * @brief compares the differences of out-weight and in-weight of two vertices (both sums fit into an uint64_t, their
+ *        difference may not fit into an int64_t, so sign and magnitude get compared separately)
+ *
+ * @param order the state of the greedy ordering
+ * @param a the first vertex
+ * @param b the second vertex
+ * @return true if the difference of a is greater than the difference of b
+ */
+static bool greedy_greater(struct greedy *order, int a, int b)
+{
+    bool a_positive = order->out_weight[a] >= order->in_weight[a];
+    bool b_positive = order->out_weight[b] >= order->in_weight[b];
+
+    if (a_positive != b_positive)
+        return a_positive;
+
+    if (a_positive)
+        return order->out_weight[a] - order->in_weight[a] > order->out_weight[b] - order->in_weight[b];
+
+    return order->in_weight[a] - order->out_weight[a] < order->in_weight[b] - order->out_weight[b];
+}
+
+/**
+ * @brief puts vertex v to position i of the heap of the greedy ordering
+ *
+ * @param order the state of the greedy ordering
+ * @param i the position in the heap
+ * @param v the vertex
+ */
+static void greedy_heap_set(struct greedy *order, int i, int v)
+{
+    order->heap[i] = v;
+    order->heap_position[v] = i;
+}
+
+/**
+ * @brief restores the heap of the greedy ordering after the difference of the vertex at position i changed
+ *
+ * @param order the state of the greedy ordering
+ * @param i the position of the vertex in the heap
+ */
+static void greedy_heap_fix(struct greedy *order, int i)
+{
+    int v = order->heap[i];
+
+    // sift up
+    while (i > 0 && greedy_greater(order, v, order->heap[(i - 1) / 2]))
+    {
+        greedy_heap_set(order, i, order->heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+
+    // sift down
+    while (2 * i + 1 < order->heap_size)
+    {
+        int child = 2 * i + 1;
+        if (child + 1 < order->heap_size && greedy_greater(order, order->heap[child + 1], order->heap[child]))
+            child++;
+        if (!greedy_greater(order, order->heap[child], v))
+            break;
+
+        greedy_heap_set(order, i, order->heap[child]);
+        i = child;
+    }
+
+    greedy_heap_set(order, i, v);
+}
+
+/**
+ * @brief inserts vertex v into the heap of the greedy ordering, or restores the heap if v is already in it
+ *
+ * @param order the state of the greedy ordering
+ * @param v the vertex
  */
-static int create_edges(char *input, int number_edges, long edge[number_edges][2], char *argv[])
+static void greedy_heap_update(struct greedy *order, int v)
 {
-    // stores rest of the string
-    char *full_rest = NULL;
+    if (order->heap_position[v] < 0)
+        greedy_heap_set(order, order->heap_size++, v);
 
-    // get the first edge (example: 1-2)
-    char *full_edge_token = strtok_r(input, " ", &full_rest);
+    greedy_heap_fix(order, order->heap_position[v]);
+}
 
-    int counter = 0;
-    int max_vertex_value = 0;
+/**
+ * @brief removes vertex v from the heap of the greedy ordering (if it is in it)
+ *
+ * @param order the state of the greedy ordering
+ * @param v the vertex
+ */
+static void greedy_heap_remove(struct greedy *order, int v)
+{
+    int i = order->heap_position[v];
+    if (i < 0)
+        return;
 
-    char *end_char;
+    order->heap_position[v] = -1;
+    int last = order->heap[--order->heap_size];
+    if (i < order->heap_size)
+    {
+        greedy_heap_set(order, i, last);
+        greedy_heap_fix(order, i);
+    }
+}
 
-    // loop as long as edges are in the rest of the string
-    while (full_edge_token != NULL)
+/**
+ * @brief moves vertex v into the given list of the greedy ordering (list 0 = sinks, list 1 = sources,
+ *        list 2 + n + delta = vertices with out-degree minus in-degree equal to delta); the lists are doubly linked
+ *
+ * @param order the state of the greedy ordering
+ * @param v the vertex which gets moved
+ * @param list the list where the vertex gets inserted
+ */
+static void greedy_move(struct greedy *order, int v, int list)
+{
+    // remove from old list
+    if (order->list[v] >= 0)
     {
-        // stores rest of the string
-        char *single_rest = NULL;
+        if (order->prev[v] >= 0)
+            order->next[order->prev[v]] = order->next[v];
+        else
+            order->head[order->list[v]] = order->next[v];
+        if (order->next[v] >= 0)
+            order->prev[order->next[v]] = order->prev[v];
+    }
 
-        // get first vertex of edge
-        char *single_edge_token = strtok_r(full_edge_token, "-", &single_rest);
-        char *first = single_edge_token;
+    order->list[v] = list;
+    if (list < 0)
+        return;
 
-        // convert current first vertex from string to long
-        long first_value = strtol(first, &end_char, 10);
+    // insert at the front of the new list
+    order->prev[v] = -1;
+    order->next[v] = order->head[list];
+    if (order->head[list] >= 0)
+        order->prev[order->head[list]] = v;
+    order->head[list] = v;
 
-        // check if current (first) vertex of edge has the highest value (index) of all vertices
-        if (first_value > max_vertex_value)
-            max_vertex_value = first_value;
+    if (list > order->max_list)
+        order->max_list = list;
+}
 
-        // pass NULL to continue splitting string with strtok_r and get second vertex of edge
-        char *second = single_edge_token = strtok_r(NULL, " ", &single_rest);
+/**
+ * @brief puts vertex v into the matching list of the greedy ordering based on its current degrees
+ *
+ * @param order the state of the greedy ordering
+ * @param v the vertex which gets classified
+ */
+static void greedy_classify(struct greedy *order, int v)
+{
+    if (order->out_degree[v] == 0)
+        greedy_move(order, v, 0);
+    else if (order->in_degree[v] == 0)
+        greedy_move(order, v, 1);
+    else if (order->weighted)
+        greedy_move(order, v, 2);
+    else
+        greedy_move(order, v, 2 + order->vertices + order->out_degree[v] - order->in_degree[v]);
+
+    if (!order->weighted)
+        return;
+
+    if (order->list[v] == 2)
+        greedy_heap_update(order, v);
+    else
+        greedy_heap_remove(order, v);
+}
 
-        // convert current second vertex from string to long
-        long second_value = strtol(second, &end_char, 10);
+/**
+ * @brief creates a topological order with the greedy heuristic of Eades, Lin and Smyth;
+ *        sinks get removed and put to the end of the order, sources get removed and put to the front of the
+ *        order; if there are neither sinks nor sources, the vertex with the max difference of out-degree and
+ *        in-degree is put to the front of the order; for a weighted graph the sums of the weights of the edges get
+ *        used instead of the degrees; linear time for an unweighted graph, O(m log n) for a weighted graph
+ *
+ * @param number_edges counted number of edges in input; is needed for edge-array
+ * @param edge two-dimensional array where all edges are stored (vertex u, vertex v, weight)
+ * @param max_index max value (index) of vertices
+ * @param vertices array where the order gets stored
+ * @param argv simple hand over of program name argv[0] for error messages
+ */
+static void greedy_order(int number_edges, long edge[number_edges][3], int max_index, int vertices[], char *argv[])
+{
+    int n = max_index + 1;
+    int lists = 2 * n + 3;
 
-        // check if current (second) vertex of edge has the highest value (index) of all vertices
-        if (second_value > max_vertex_value)
-            max_vertex_value = second_value;
+    struct greedy order = {.vertices = n, .max_list = 0, .weighted = false};
+    for (int i = 0; i < number_edges; i++)
+    {
+        if (edge[i][2] != 1)
+            order.weighted = true;
+    }
 
-        // check if vertex is connected to itself --> not allowed
-        if (first_value == second_value)
+    // one allocation for all arrays of the greedy ordering (the heap and the weights only for a weighted graph)
+    int *memory = malloc(sizeof(int) * (9 * n + 2 * number_edges + 4 + lists + (order.weighted ? 2 * n : 0)));
+    uint64_t *weights = order.weighted ? malloc(sizeof(uint64_t) * 2 * n) : NULL;
+    if (memory == NULL || (order.weighted && weights == NULL))
+    {
+        fprintf(stderr, "%s Error while allocating memory: %s\n", argv[0], strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    order.out_degree = memory;
+    order.in_degree = order.out_degree + n;
+    order.list = order.in_degree + n;
+    order.next = order.list + n;
+    order.prev = order.next + n;
+    order.head = order.prev + n;
+    int *out_start = order.head + lists;
+    int *in_start = out_start + n + 1;
+    int *out_adj = in_start + n + 1;
+    int *in_adj = out_adj + number_edges;
+    int *fill = in_adj + number_edges;
+    if (order.weighted)
+    {
+        order.heap = fill + 2 * n;
+        order.heap_position = order.heap + n;
+        order.heap_size = 0;
+        order.out_weight = weights;
+        order.in_weight = weights + n;
+        memset(weights, 0, sizeof(uint64_t) * 2 * n);
+    }
+
+    // build up adjacency arrays of the edges to successors and from predecessors
+    memset(order.out_degree, 0, sizeof(int) * 2 * n);
+    for (int i = 0; i < number_edges; i++)
+    {
+        order.out_degree[edge[i][0]]++;
+        order.in_degree[edge[i][1]]++;
+        if (order.weighted)
         {
-            fprintf(stderr, "%s Invalid Edge! At least one vertex is connected to itself!\n", argv[0]);
-            exit(EXIT_FAILURE);
+            order.out_weight[edge[i][0]] += edge[i][2];
+            order.in_weight[edge[i][1]] += edge[i][2];
+        }
+    }
+    out_start[0] = in_start[0] = 0;
+    for (int v = 0; v < n; v++)
+    {
+        out_start[v + 1] = out_start[v] + order.out_degree[v];
+        in_start[v + 1] = in_start[v] + order.in_degree[v];
+    }
+    memcpy(fill, out_start, sizeof(int) * n);
+    memcpy(fill + n, in_start, sizeof(int) * n);
+    for (int i = 0; i < number_edges; i++)
+    {
+        out_adj[fill[edge[i][0]]++] = i;
+        in_adj[fill[n + edge[i][1]]++] = i;
+    }
+
+    for (int i = 0; i < lists; i++)
+    {
+        order.head[i] = -1;
+    }
+    for (int v = 0; v < n; v++)
+    {
+        order.list[v] = -1;
+        if (order.weighted)
+            order.heap_position[v] = -1;
+    }
+    for (int v = 0; v < n; v++)
+    {
+        greedy_classify(&order, v);
+    }
+
+    int front = 0, back = n - 1;
+    while (front <= back)
+    {
+        int v;
+        if (order.head[0] >= 0)
+        {
+            v = order.head[0];
+            vertices[back--] = v;
+        }
+        else if (order.head[1] >= 0)
+        {
+            v = order.head[1];
+            vertices[front++] = v;
+        }
+        else if (order.weighted)
+        {
+            v = order.heap[0];
+            vertices[front++] = v;
+        }
+        else
+        {
+            while (order.head[order.max_list] < 0)
+                order.max_list--;
+            v = order.head[order.max_list];
+            vertices[front++] = v;
         }
 
-        // check if same edge already exists; without this for-loop code works perfectly fine too, but duplicates of
-        // edges get saved in edge-array too --> doesn't matter but is maybe inefficient
-        for (int i = 0; i < counter; i++)
+        // remove vertex and update degrees (and weights) of its remaining neighbours
+        greedy_move(&order, v, -1);
+        if (order.weighted)
+            greedy_heap_remove(&order, v);
+        for (int i = out_start[v]; i < out_start[v + 1]; i++)
         {
-            if (first_value == edge[i][0] && second_value == edge[i][1])
+            int w = edge[out_adj[i]][1];
+            if (order.list[w] >= 0)
             {
-                fprintf(stderr, "%s Invalid Edge! At least one edge already exists!\n", argv[0]);
-                exit(EXIT_FAILURE);
+                order.in_degree[w]--;
+                if (order.weighted)
+                    order.in_weight[w] -= edge[out_adj[i]][2];
+                greedy_classify(&order, w);
+            }
+        }
+        for (int i = in_start[v]; i < in_start[v + 1]; i++)
+        {
+            int w = edge[in_adj[i]][0];
+            if (order.list[w] >= 0)
+            {
+                order.out_degree[w]--;
+                if (order.weighted)
+                    order.out_weight[w] -= edge[in_adj[i]][2];
+                greedy_classify(&order, w);
             }
         }
-
-        // store vertices of edges in array
-        edge[counter][0] = first_value;
-        edge[counter++][1] = second_value;
-
-        // pass NULL to continue splitting string with strtok_r and get other edges
-        full_edge_token = strtok_r(NULL, " ", &full_rest);
     }
 
-    return max_vertex_value;
+    free(weights);
+    free(memory);
 }
 
 /**
- * @brief shuffles vertices-array using the Fisher-Yates shuffle
+ * @brief perturbs the given order by swapping a few (1 to 3) random pairs of vertices
  *
- * @param vertices array where all vertices are stored in ascending order
+ * @param vertices array where all vertices are stored
  * @param max_index max value (index) of vertices
  */
-static void shuffle(int vertices[], int max_index)
+static void perturb(int vertices[], int max_index)
 {
-    int i, j, temp;
+    int swaps = 1 + rand() % 3;
 
-    // call rand one time before usage to fix pseudo random effect (often same numbers when first called)
-    rand();
+    for (int s = 0; s < swaps; s++)
+    {
+        int i = rand() % (max_index + 1);
+        int j = rand() % (max_index + 1);
 
-    for (i = max_index; i > 0; i--)
+        int temp = vertices[i];
+        vertices[i] = vertices[j];
+        vertices[j] = temp;
+    }
+}
+
+/**
+ * @brief state of the exact branch-and-bound search;
+ *        out[v]/in[v] are bitsets of the successors/predecessors of vertex v, weight[u][v] is the weight of edge
+ *        u-v, order is the current (partial) topological order and best_order the best complete order found so far
+ *
+ */
+struct exact_search
+{
+    int vertices;
+    uint32_t out[EXACT_MAX_VERTICES];
+    uint32_t in[EXACT_MAX_VERTICES];
+    uint64_t weight[EXACT_MAX_VERTICES][EXACT_MAX_VERTICES];
+    int order[EXACT_MAX_VERTICES];
+    int best_order[EXACT_MAX_VERTICES];
+    uint64_t best_cost;
+    struct exact_cache *cache;
+};
+
+/**
+ * @brief defines an entry of the (lossy) cache of already visited sets of placed vertices and the cost with
+ *        which the set was reached; if the same set gets reached again with at least the same cost, the search
+ *        can be pruned, because the cost of the remaining vertices does not depend on the order within the set
+ *
+ */
+struct exact_cache
+{
+    uint32_t placed;
+    uint64_t cost;
+};
+
+/**
+ * @brief returns the sum of the weights of all edges from vertex v to the vertices of the given bitset
+ *
+ * @param search the state of the search
+ * @param v the vertex
+ * @param set the bitset of vertices
+ * @return uint64_t the sum of the weights
+ */
+static uint64_t weight_to(struct exact_search *search, int v, uint32_t set)
+{
+    uint64_t sum = 0;
+    for (uint32_t bits = search->out[v] & set; bits != 0; bits &= bits - 1)
     {
-        j = rand() % (max_index + 1);
+        sum += search->weight[v][__builtin_ctz(bits)];
+    }
+    return sum;
+}
 
-        // shuffle values
-        temp = vertices[j];
-        vertices[j] = vertices[i];
-        vertices[i] = temp;
+/**
+ * @brief returns the lower bound of the cost of the remaining (not yet placed) vertices; of every 2-cycle
+ *        (u-v and v-u) between remaining vertices at least the lighter edge is in the feedback arc set
+ *
+ * @param search the state of the search
+ * @param remaining bitset of the remaining vertices
+ * @return uint64_t the lower bound
+ */
+static uint64_t lower_bound(struct exact_search *search, uint32_t remaining)
+{
+    uint64_t cycles = 0;
+    for (int u = 0; u < search->vertices; u++)
+    {
+        if (!(remaining & (1u << u)))
+            continue;
+
+        // only count every 2-cycle once (v > u)
+        uint32_t bits = search->out[u] & search->in[u] & remaining & ~((2u << u) - 1);
+        for (; bits != 0; bits &= bits - 1)
+        {
+            int v = __builtin_ctz(bits);
+            cycles += search->weight[u][v] < search->weight[v][u] ? search->weight[u][v] : search->weight[v][u];
+        }
     }
+    return cycles;
 }
 
 /**
- * @brief checks if vertices of edge are in topological order based on their index
+ * @brief returns the max cost a (better) solution may have; this is one less than the best solution found so far,
+ *        but at most the best solution the supervisor got from the heuristic generators (read from the shared
+ *        memory), because the edges of that solution are not known here
  *
- * @param value_1 first vertex 'u' of edge
- * @param value_2 second vertex 'v' of edge
- * @param vertices array where all vertices are stored
- * @param max_index max value (index) of vertices
- * @return true if vertices are in topological order
- * @return false if vertices are not in topological order
+ * @param search the state of the search
+ * @return uint64_t the max cost
  */
-static bool inOrder(long value_1, long value_2, int vertices[], int max_index)
+static uint64_t upper_bound(struct exact_search *search)
 {
-    int index_v1, index_v2;
+    uint64_t bound = search->best_cost - 1;
+    if (buff != NULL && buff->best_cost < bound)
+        bound = buff->best_cost;
+    return bound;
+}
 
-    // find indices of values
-    for (int i = 0; i < max_index + 1; i++)
+/**
+ * @brief branch and bound over topological orders; places one of the remaining vertices at the next position;
+ *        the cost of placing vertex v after the already placed vertices are the weights of all edges v-u with u
+ *        already placed
+ *
+ * @param search the state of the search
+ * @param position the position in the order which gets filled
+ * @param placed bitset of the already placed vertices
+ * @param cost the cost of the feedback arc set of the already placed vertices
+ */
+static void branch_and_bound(struct exact_search *search, int position, uint32_t placed, uint64_t cost)
+{
+    uint64_t bound = upper_bound(search);
+    if (cost > bound || (buff != NULL && !buff->state))
+        return;
+
+    if (position == search->vertices)
     {
-        if (vertices[i] == value_1)
-            index_v1 = i;
-        else if (vertices[i] == value_2)
-            index_v2 = i;
+        search->best_cost = cost;
+        memcpy(search->best_order, search->order, sizeof(search->order));
+        return;
     }
 
-    // check if values are in topological order
-    return index_v1 < index_v2;
+    uint32_t all = search->vertices == 32 ? UINT32_MAX : (1u << search->vertices) - 1;
+    uint32_t remaining = all & ~placed;
+
+    if (cost + lower_bound(search, remaining) > bound)
+        return;
+
+    // prune if this set of placed vertices was already reached with at most the same cost
+    if (placed != 0)
+    {
+        struct exact_cache *entry = &search->cache[(placed * 2654435761u) >> (32 - EXACT_CACHE_BITS)];
+        if (entry->placed == placed && entry->cost <= cost)
+            return;
+        entry->placed = placed;
+        entry->cost = cost;
+    }
+
+    // sort remaining vertices by their additional cost (insertion sort), so that the cheapest get tried first
+    int candidates = 0;
+    int candidate[EXACT_MAX_VERTICES];
+    uint64_t added[EXACT_MAX_VERTICES];
+    for (int v = 0; v < search->vertices; v++)
+    {
+        if (!(remaining & (1u << v)))
+            continue;
+
+        uint64_t weight = weight_to(search, v, placed);
+        int i = candidates++;
+        for (; i > 0 && added[i - 1] > weight; i--)
+        {
+            candidate[i] = candidate[i - 1];
+            added[i] = added[i - 1];
+        }
+        candidate[i] = v;
+        added[i] = weight;
+    }
+
+    for (int i = 0; i < candidates && cost + added[i] <= bound; i++)
+    {
+        search->order[position] = candidate[i];
+        branch_and_bound(search, position + 1, placed | (1u << candidate[i]), cost + added[i]);
+
+        // bound may have changed
+        bound = upper_bound(search);
+    }
 }
 
 /**
- * @brief finds minimal feedback arc of given vertices-array and edge-array
+ * @brief finds a minimal feedback arc set (minimal cost) of the given graph exactly, using branch and bound over
+ *        all topological orders; the search is seeded with the order of the greedy heuristic; only possible for
+ *        graphs with at most EXACT_MAX_VERTICES vertices
  *
- * @param vertices array where all vertices are stored
  * @param number_edges counted number of edges in input; is needed for edge-array
- * @param edge two-dimensional array where all edges are stored
+ * @param edge two-dimensional array where all edges are stored (vertex u, vertex v, weight)
  * @param max_index max value (index) of vertices
- * @param fb_arc_set empty fb_arc_set-array where solutions are getting stored
- * @return int the number of edges in the feedback arc set
+ * @param fb_arc_set empty fb_arc_set-array where the solution is getting stored
+ * @param cost the cost of the minimal feedback arc set gets stored here
+ * @param argv simple hand over of program name argv[0] for error messages
+ * @return int the number of edges in the minimal feedback arc set (can be greater than 8)
  */
-static int find_fb_arc_set(int vertices[], int number_edges, long edge[number_edges][2], int max_index, long fb_arc_set[8][2])
+static int find_exact_fb_arc_set(int number_edges, long edge[number_edges][3], int max_index, long fb_arc_set[8][2],
+                                 uint64_t *cost, char *argv[])
 {
-    // init fb_counter
-    int fb_counter = 0;
+    struct exact_search search = {.vertices = max_index + 1};
+
+    // the empty set is never cached, so zeroed entries are unused entries
+    search.cache = calloc((size_t)1 << EXACT_CACHE_BITS, sizeof(struct exact_cache));
+    if (search.cache == NULL)
+    {
+        fprintf(stderr, "%s Error while allocating memory: %s\n", argv[0], strerror(errno));
+        exit(EXIT_FAILURE);
+    }
 
-    // add all edges which are not in order to fb arc set and increment fb_counter
     for (int i = 0; i < number_edges; i++)
     {
-        if (!inOrder(edge[i][0], edge[i][1], vertices, max_index))
-        {
-            fb_arc_set[fb_counter][0] = edge[i][0];
-            fb_arc_set[fb_counter++][1] = edge[i][1];
-        }
+        search.out[edge[i][0]] |= 1u << edge[i][1];
+        search.in[edge[i][1]] |= 1u << edge[i][0];
+        search.weight[edge[i][0]][edge[i][1]] = edge[i][2];
+    }
 
-        if (fb_counter >= 8)
-            break;
+    // seed with the solution of the greedy heuristic
+    int position[EXACT_MAX_VERTICES];
+    greedy_order(number_edges, edge, max_index, search.best_order, argv);
+    find_fb_arc_set(search.best_order, position, number_edges, edge, max_index, fb_arc_set, &search.best_cost);
+
+    // search for a solution which is at least one cheaper (the order within the cost 0 case is already minimal)
+    if (search.best_cost > 0)
+    {
+        branch_and_bound(&search, 0, 0, 0);
     }
-    return fb_counter;
+    free(search.cache);
+
+    // all edges which are not in order are in the fb arc set
+    return find_fb_arc_set(search.best_order, position, number_edges, edge, max_index, fb_arc_set, cost);
 }
 
 /**
@@ -239,7 +745,7 @@ static int find_fb_arc_set(int vertices[], int number_edges, long edge[number_ed
 static void shm_sem_setup(char *argv[])
 {
     // open the shared memory object
-    shm_fd = shm_open(SHM_NAME, O_RDWR, 0600);
+    shm_fd = shm_open(shm_name, O_RDWR, 0600);
     if (shm_fd == -1)
     {
         fprintf(stderr, "%s Error while opening an existing shared memory object: %s\n", argv[0], strerror(errno));
@@ -253,20 +759,20 @@ static void shm_sem_setup(char *argv[])
     }
 
     // open semaphores
-    free_sem = sem_open(SEM_FREE_NAME, BUFFER_SIZE);
+    free_sem = sem_open(sem_free_name, BUFFER_SIZE);
     if (free_sem == SEM_FAILED)
     {
         fprintf(stderr, "%s Error while creating and/or opening (a) new/existing semaphore(s) free: %s\n", argv[0], strerror(errno));
         // fprintf(stderr, "%s Input file %s not found\n", argv[0], argv[i]);
         cleanup_shm_sem(2, EXIT_FAILURE, &argv[0]);
     }
-    used_sem = sem_open(SEM_USED_NAME, 0);
+    used_sem = sem_open(sem_used_name, 0);
     if (used_sem == SEM_FAILED)
     {
         fprintf(stderr, "%s Error while creating and/or opening (a) new/existing semaphore(s) used: %s\n", argv[0], strerror(errno));
         cleanup_shm_sem(3, EXIT_FAILURE, &argv[0]);
     }
-    blocked_sem = sem_open(SEM_BLOCKED_NAME, 1);
+    blocked_sem = sem_open(sem_blocked_name, 1);
     if (blocked_sem == SEM_FAILED)
     {
         fprintf(stderr, "%s Error while creating and/or opening (a) new/existing semaphore(s) blocked: %s\n", argv[0], strerror(errno));
@@ -275,89 +781,183 @@ static void shm_sem_setup(char *argv[])
 }
 
 /**
- * @brief Sets up signal handling; checks correct program call; writes generated results to the circular buffer;
- *        produces simple debug output, which describes fb arc set which is being written to the circular buffer;
- *        calls appropriate functions to make the program work how it should;
+ * @brief writes the given feedback arc set to the circular buffer; produces simple debug output, which describes
+ *        the fb arc set which is being written to the circular buffer
  *
- * @param argc number of arguments of the program call
- * @param argv array of the arguments of the program call
- * @return int return value of main method to tell when program is finished (and therefore can be removed from memory)
+ * @param fb_amount the number of edges in the feedback arc set
+ * @param fb_cost the cost of the feedback arc set (sum of the weights of all its edges)
+ * @param fb_arc_set the edges of the feedback arc set
+ * @param optimal true if the feedback arc set is known to be minimal (exact mode)
+ * @param argv simple hand over of program name argv[0] for error messages
+ * @return true if the fb arc set got written
+ * @return false if the supervisor is not running anymore
  */
-int main(int argc, char *argv[])
+static bool write_to_buffer(int fb_amount, uint64_t fb_cost, long fb_arc_set[8][2], bool optimal, char *argv[])
 {
-    // check if at least one edge is given
-    if (argc <= 1)
+    if (sem_wait(blocked_sem) == -1)
     {
-        fprintf(stderr, "%s You have to specify at least one edge!\n", argv[0]);
-        return EXIT_FAILURE;
+        fprintf(stderr, "%s Error while semaphore is waiting: %s\n", argv[0], strerror(errno));
+        exit(EXIT_FAILURE);
     }
 
-    // index to count through all given arguments
-    int count = 1;
-
-    size_t length = 0;
+    // mark this generator as current writer (needed by the supervisor if this generator crashes)
+    buff->writer.pid = getpid();
+    buff->writer.stage = 1;
 
-    // count number of chars in all given arguments
-    while (count < argc)
+    if (!buff->state)
     {
-            length += strlen(argv[count++]);
+        buff->writer.pid = 0;
+        buff->writer.stage = 0;
+        sem_post(used_sem);
+        sem_post(blocked_sem);
+        return false;
     }
 
-    // add number of whitespaces which are needed between edges to length
-    length += argc - 2;
+    if (sem_wait(free_sem) == -1)
+    {
+        buff->writer.pid = 0;
+        buff->writer.stage = 0;
+        sem_post(blocked_sem);
+        sem_post(used_sem);
+        if (errno != EINTR)
+        {
+            fprintf(stderr, "%s Error while semaphore is waiting: %s\n", argv[0], strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        return false;
+    }
+    buff->writer.stage = 2;
 
-    // reset count
-    count = 1;
+    for (int i = 0; i < fb_amount; i++)
+    {
+        printf("writing to wr_pos: %d, fb_arc_set-index: %d, edges: %ld-%ld\n", buff->wr_pos, i, fb_arc_set[i][0], fb_arc_set[i][1]);
 
-    // create input char array based on determined length
-    char input[length];
+        buff->buffer[buff->wr_pos].fb_arc_set[i].vertex_u = fb_arc_set[i][0];
+        buff->buffer[buff->wr_pos].fb_arc_set[i].vertex_v = fb_arc_set[i][1];
+    }
+    printf("number of edges: %d, cost: %llu\n", fb_amount, (unsigned long long)fb_cost);
 
-    int index = 0;
+    buff->buffer[buff->wr_pos].edge_number = fb_amount;
+    buff->buffer[buff->wr_pos].cost = fb_cost;
+    buff->buffer[buff->wr_pos].optimal = optimal;
+    buff->wr_pos++;
+    buff->wr_pos %= BUFFER_SIZE;
+    buff->writer.stage = 3;
 
-    // loop through all arguments
-    while (count < argc)
-    {
-        int i = 0;
+    buff->writer.pid = 0;
+    buff->writer.stage = 0;
+    sem_post(used_sem);
+    sem_post(blocked_sem);
 
-        // loop through all chars of current argument
-        while (argv[count][i] != '\0')
-        {
-            // add current char of current argument to char array
-            input[index++] = argv[count][i++];
-        }
+    return true;
+}
 
-        // increment counter for arguments
-        count++;
+/**
+ * @brief Sets up signal handling; checks correct program call; writes generated results to the circular buffer;
+ *        produces simple debug output, which describes fb arc set which is being written to the circular buffer;
+ *        calls appropriate functions to make the program work how it should;
+ *
+ * @param argc number of arguments of the program call
+ * @param argv array of the arguments of the program call
+ * @return int return value of main method to tell when program is finished (and therefore can be removed from memory)
+ */
+int main(int argc, char *argv[])
+{
+    char *instance = NULL;
+    bool exact = false;
+    bool greedy = false;
 
-        // add whitespace to char array (only if not last char of current argument)
-        if (index < length)
+    // get options
+    int c;
+    while ((c = getopt(argc, argv, "n:eg")) != -1)
+    {
+        switch (c)
         {
-            input[index++] = ' ';
+        case 'g':
+            if (greedy)
+            {
+                fprintf(stderr, "SYNOPSIS:\n%s [-n NAME] [-e | -g] [EDGE1...]\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            greedy = true;
+            break;
+        case 'e':
+            if (exact)
+            {
+                fprintf(stderr, "SYNOPSIS:\n%s [-n NAME] [-e | -g] [EDGE1...]\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            exact = true;
+            break;
+        case 'n':
+            if (instance != NULL)
+            {
+                fprintf(stderr, "SYNOPSIS:\n%s [-n NAME] [-e | -g] [EDGE1...]\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            instance = optarg;
+            break;
+        default:
+            fprintf(stderr, "SYNOPSIS:\n%s [-n NAME] [-e | -g] [EDGE1...]\n", argv[0]);
+            exit(EXIT_FAILURE);
         }
     }
 
-    /* short explanation why arguments get appended to string in code above and get splitted in create_edges-methode
-    below: implementation of code below happened first, so it was necessary to "build" the string in the code above */
+    if (exact && greedy)
+    {
+        fprintf(stderr, "SYNOPSIS:\n%s [-n NAME] [-e | -g] [EDGE1...]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
 
-    // count occurrence of '-' (and therefore number of edges)
-    int number_edges;
-    char *temp_input = strdup(input);
+    // build up names of shm and semaphores of the wanted instance
+    if (!init_ipc_names(instance))
+    {
+        fprintf(stderr, "%s Invalid instance name!\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
 
-    // save pointer to free char pointer later
-    char *temp_pointer = temp_input;
+    int number_edges;
+    char *input = NULL;
 
-    for (number_edges = 0; temp_input[number_edges]; temp_input[number_edges] == '-' ? number_edges++ : *temp_input++)
+    if (argc - optind > 0)
     {
+        // build up input string of all given edges and count the edges
+        input = join_edges(argc - optind, &argv[optind], &argv[0]);
+        number_edges = count_edges(input);
+    }
+    else
+    {
+        // no edges given --> the graph was written to the shared memory by the supervisor
+        shm_sem_setup(&argv[0]);
+        number_edges = buff->graph.number_edges;
+
+        if (number_edges < 1)
+        {
+            fprintf(stderr, "%s You have to specify at least one edge!\n", argv[0]);
+            cleanup_shm_sem(5, EXIT_FAILURE, &argv[0]);
+        }
     }
-    free(temp_pointer);
 
     // initialize 2-d array
-    long edge[number_edges][2];
+    long edge[number_edges][3];
+    int max_index;
+    bool weighted = false;
 
-    // stores edges based on input in array and also returns max value (index) of vertices
-    int max_index = create_edges(input, number_edges, edge, &argv[0]);
+    if (input != NULL)
+    {
+        // stores edges based on input in array and also returns max value (index) of vertices
+        max_index = create_edges(input, number_edges, edge, &weighted, &argv[0]);
+        free(input);
+    }
+    else
+    {
+        // copy edges from shared memory
+        memcpy(edge, buff->graph.edge, sizeof(edge));
+        max_index = buff->graph.max_vertex;
+    }
 
     int fb_amount;
+    uint64_t fb_cost;
     long fb_arc_set[8][2];
 
     // init random number generator with seed which consists of process id and time in nanoseconds for rand in shuffle
@@ -384,55 +984,95 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
-    // setup shm and semaphores
-    shm_sem_setup(&argv[0]);
+    // setup shm and semaphores (if not already done to get the graph)
+    if (buff == NULL)
+    {
+        shm_sem_setup(&argv[0]);
+    }
 
-    // find fb_arc_set of shuffled vertices-array;
-    // the already shuffled array gets shuffled again every loop
-    while (buff->state)
+    // tell the supervisor to print the cost of the solutions of a weighted graph
+    if (weighted)
     {
-        // shuffle vertices-array
-        shuffle(vertices, max_index);
-        fb_amount = find_fb_arc_set(vertices, number_edges, edge, max_index, fb_arc_set);
+        buff->graph.weighted = true;
+    }
 
-        if (sem_wait(blocked_sem) == -1)
+    // exact mode: find one minimal fb_arc_set, write it and terminate
+    if (exact)
+    {
+        if (max_index + 1 > EXACT_MAX_VERTICES)
         {
-            fprintf(stderr, "%s Error while semaphore is waiting: %s\n", argv[0], strerror(errno));
-            exit(EXIT_FAILURE);
+            fprintf(stderr, "%s Exact mode is only possible for at most %d vertices!\n", argv[0], EXACT_MAX_VERTICES);
+            cleanup_shm_sem(5, EXIT_FAILURE, &argv[0]);
         }
 
+        fb_amount = find_exact_fb_arc_set(number_edges, edge, max_index, fb_arc_set, &fb_cost, &argv[0]);
+
         if (!buff->state)
         {
             sem_post(used_sem);
-            break;
         }
+        else if (fb_amount > 8)
+        {
+            // the supervisor reports the number of edges instead of the solution
+            fprintf(stderr, "%s Minimal feedback arc set has %d > 8 edges (cost %llu)\n", argv[0], fb_amount,
+                    (unsigned long long)fb_cost);
+            buff->exact_edges = fb_amount;
+            cleanup_shm_sem(5, EXACT_TOO_MANY_EDGES, &argv[0]);
+        }
+        else
+        {
+            write_to_buffer(fb_amount, fb_cost, fb_arc_set, true, &argv[0]);
+        }
+        cleanup_shm_sem(5, EXIT_SUCCESS, &argv[0]);
+    }
 
-        if (sem_wait(free_sem) == -1)
+    // greedy mode: start with the order of the greedy heuristic, which gets perturbed in every loop
+    int position[max_index + 1];
+    int candidate[max_index + 1];
+    uint64_t best_cost = UINT64_MAX;
+    if (greedy)
+    {
+        greedy_order(number_edges, edge, max_index, vertices, &argv[0]);
+        memcpy(candidate, vertices, sizeof(vertices));
+    }
+
+    // find fb_arc_set of shuffled vertices-array;
+    // the already shuffled array gets shuffled again every loop
+    while (buff->state)
+    {
+        if (greedy)
         {
-            sem_post(blocked_sem);
-            sem_post(used_sem);
-            if (errno != EINTR)
+            // keep perturbed order if it is not more expensive; only write improvements
+            fb_amount = find_fb_arc_set(candidate, position, number_edges, edge, max_index, fb_arc_set, &fb_cost);
+            if (fb_cost > best_cost)
             {
-                fprintf(stderr, "%s Error while semaphore is waiting: %s\n", argv[0], strerror(errno));
-                exit(EXIT_FAILURE);
+                memcpy(candidate, vertices, sizeof(vertices));
+                perturb(candidate, max_index);
+                continue;
             }
-        }
+            bool improved = fb_cost < best_cost;
+            best_cost = fb_cost;
+            memcpy(vertices, candidate, sizeof(vertices));
+            perturb(candidate, max_index);
 
-        for (int i = 0; i < fb_amount; i++)
+            if (!improved)
+                continue;
+        }
+        else
         {
-            printf("writing to wr_pos: %d, fb_arc_set-index: %d, edges: %ld-%ld\n", buff->wr_pos, i, fb_arc_set[i][0], fb_arc_set[i][1]);
-
-            buff->buffer[buff->wr_pos].fb_arc_set[i].vertex_u = fb_arc_set[i][0];
-            buff->buffer[buff->wr_pos].fb_arc_set[i].vertex_v = fb_arc_set[i][1];
+            // shuffle vertices-array
+            shuffle(vertices, max_index);
+            fb_amount = find_fb_arc_set(vertices, position, number_edges, edge, max_index, fb_arc_set, &fb_cost);
         }
-        printf("number of edges: %d\n", fb_amount);
 
-        buff->buffer[buff->wr_pos].edge_number = fb_amount;
-        buff->wr_pos++;
-        buff->wr_pos %= BUFFER_SIZE;
+        // only solutions with at most 8 edges fit into the circular buffer
+        if (fb_amount > 8)
+            continue;
 
-        sem_post(used_sem);
-        sem_post(blocked_sem);
+        if (!write_to_buffer(fb_amount, fb_cost, fb_arc_set, false, &argv[0]))
+        {
+            break;
+        }
     }
     sem_post(used_sem);
     cleanup_shm_sem(5, EXIT_SUCCESS, &argv[0]);
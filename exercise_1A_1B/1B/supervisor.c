@@ -7,7 +7,24 @@
  *
  */
 
+#define _GNU_SOURCE
 #include "circular_buffer.h"
+#include <sys/wait.h>
+#include <sched.h>
+
+/**
+ * @brief max number of generators which can be started in the generator pool;
+ *        exit code of a generator process which could not execute the generator binary
+ *
+ */
+#define MAX_GENERATORS (1024)
+#define EXEC_FAILED (127)
+
+/**
+ * @brief is set if a generator of the pool terminated
+ *
+ */
+static volatile sig_atomic_t child_exited = 0;
 
 /**
  * @brief Function to handle signals;
@@ -17,6 +34,25 @@
  */
 static void handle_signal(int signal) { buff->state = false; }
 
+/**
+ * @brief Function to handle SIGCHLD;
+ *        In this case 'child_exited' will be set, so that terminated generators get restarted
+ *
+ * @param signal signal number to which the handling function is set
+ */
+static void handle_child(int signal) { child_exited = 1; }
+
+/**
+ * @brief Prints the correct usage(synopsis) of the program to stderr and exits
+ *
+ * @param name the program name argv[0]
+ */
+static void usage(char *name)
+{
+    fprintf(stderr, "SYNOPSIS:\n%s [-n NAME] [-l GENERATORS [-e] [-g] EDGE1...]\n", name);
+    exit(EXIT_FAILURE);
+}
+
 /**
  * @brief Function to clean up shared memory and semaphores before exiting the program
  *
@@ -35,7 +71,7 @@ static void cleanup_shm_sem(int cleanup_state, int exit_code, char *argv[])
         {
             fprintf(stderr, "%s Error while closing semaphore: %s\n", argv[0], strerror(errno));
         }
-        if (sem_unlink(SEM_BLOCKED_NAME) == -1)
+        if (sem_unlink(sem_blocked_name) == -1)
         {
             fprintf(stderr, "%s Error while unlinking semaphore: %s\n", argv[0], strerror(errno));
         }
@@ -45,7 +81,7 @@ static void cleanup_shm_sem(int cleanup_state, int exit_code, char *argv[])
         {
             fprintf(stderr, "%s Error while closing semaphore: %s\n", argv[0], strerror(errno));
         }
-        if (sem_unlink(SEM_USED_NAME) == -1)
+        if (sem_unlink(sem_used_name) == -1)
         {
             fprintf(stderr, "%s Error while unlinking semaphore: %s\n", argv[0], strerror(errno));
         }
@@ -55,7 +91,7 @@ static void cleanup_shm_sem(int cleanup_state, int exit_code, char *argv[])
         {
             fprintf(stderr, "%s Error while closing semaphore: %s\n", argv[0], strerror(errno));
         }
-        if (sem_unlink(SEM_FREE_NAME) == -1)
+        if (sem_unlink(sem_free_name) == -1)
         {
             fprintf(stderr, "%s Error while unlinking semaphore: %s\n", argv[0], strerror(errno));
         }
@@ -77,7 +113,7 @@ static void cleanup_shm_sem(int cleanup_state, int exit_code, char *argv[])
 
     case 1:
         // remove shared memory object; print error message if not successful
-        if (shm_unlink(SHM_NAME) == -1)
+        if (shm_unlink(shm_name) == -1)
         {
             fprintf(stderr, "%s Error while unlinking memory object: %s\n", argv[0], strerror(errno));
         }
@@ -97,7 +133,7 @@ static void cleanup_shm_sem(int cleanup_state, int exit_code, char *argv[])
 static void shm_sem_setup(char *argv[])
 {
     // create and/or open the shared memory object; print error message if not successful
-    shm_fd = shm_open(SHM_NAME, O_CREAT | O_RDWR | O_EXCL, 0600);
+    shm_fd = shm_open(shm_name, O_CREAT | O_RDWR | O_EXCL, 0600);
     if (shm_fd == -1)
     {
         fprintf(stderr, "%s Error while creating and opening a new shared memory object: %s\n", argv[0], strerror(errno));
@@ -119,19 +155,19 @@ static void shm_sem_setup(char *argv[])
     }
 
     //  open semaphores; cleanup and print error message if not successful
-    free_sem = sem_open(SEM_FREE_NAME, O_CREAT | O_EXCL, 0600, BUFFER_SIZE);
+    free_sem = sem_open(sem_free_name, O_CREAT | O_EXCL, 0600, BUFFER_SIZE);
     if (free_sem == SEM_FAILED)
     {
         fprintf(stderr, "%s Error while creating and/or opening (a) new/existing semaphore(s) free: %s\n", argv[0], strerror(errno));
         cleanup_shm_sem(3, EXIT_FAILURE, &argv[0]);
     }
-    used_sem = sem_open(SEM_USED_NAME, O_CREAT | O_EXCL, 0600, 0);
+    used_sem = sem_open(sem_used_name, O_CREAT | O_EXCL, 0600, 0);
     if (used_sem == SEM_FAILED)
     {
         fprintf(stderr, "%s Error while creating and/or opening (a) new/existing semaphore(s) used: %s\n", argv[0], strerror(errno));
         cleanup_shm_sem(4, EXIT_FAILURE, &argv[0]);
     }
-    blocked_sem = sem_open(SEM_BLOCKED_NAME, O_CREAT | O_EXCL, 0600, 1);
+    blocked_sem = sem_open(sem_blocked_name, O_CREAT | O_EXCL, 0600, 1);
     if (blocked_sem == SEM_FAILED)
     {
         fprintf(stderr, "%s Error while creating and/or opening (a) new/existing semaphore(s) blocked: %s\n", argv[0], strerror(errno));
@@ -139,6 +175,219 @@ static void shm_sem_setup(char *argv[])
     }
 }
 
+/**
+ * @brief Pins the calling generator to one of the cores on which the supervisor may run (round robin over the
+ *        generators); the cores which are not allowed (e.g. because of taskset or a cpuset) are skipped
+ *
+ * @param index the index of the generator in the pool
+ * @param argv simple hand over of program name argv[0] for error messages
+ */
+static void pin_generator(int index, char *argv[])
+{
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1 || CPU_COUNT(&allowed) == 0)
+        return;
+
+    int target = index % CPU_COUNT(&allowed);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (!CPU_ISSET(cpu, &allowed) || target-- > 0)
+            continue;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) == -1)
+        {
+            fprintf(stderr, "%s Cannot pin generator to core: %s\n", argv[0], strerror(errno));
+        }
+        return;
+    }
+}
+
+/**
+ * @brief Starts one generator of the pool; the generator gets attached to the same instance as the supervisor and
+ *        reads the graph from the shared memory; the generator gets pinned to one core (index modulo number of
+ *        allowed cores); the generator binary is expected in the same directory as the supervisor
+ *
+ * @param index the index of the generator in the pool
+ * @param pid array where the process ids of the generators get stored
+ * @param instance the instance name or NULL
+ * @param mode option of the mode of the generator ("-e" for exact mode, "-g" for greedy mode) or NULL
+ * @param argv simple hand over of program name argv[0] for error messages
+ * @return true if the generator got started
+ * @return false if fork failed
+ */
+static bool start_generator(int index, pid_t pid[], char *instance, char *mode, char *argv[])
+{
+    // derive path of generator from path of supervisor (e.g. "./supervisor" -> "./generator")
+    char *slash = strrchr(argv[0], '/');
+    size_t dir_length = slash == NULL ? 0 : (size_t)(slash - argv[0] + 1);
+    char generator_path[dir_length + strlen("generator") + 1];
+    memcpy(generator_path, argv[0], dir_length);
+    strcpy(generator_path + dir_length, "generator");
+
+    // build up arguments of generator: path, [-n NAME], [MODE], NULL --> no edges, so graph gets read from shm
+    char *generator_argv[5];
+    int argc = 0;
+    generator_argv[argc++] = generator_path;
+    if (instance != NULL)
+    {
+        generator_argv[argc++] = "-n";
+        generator_argv[argc++] = instance;
+    }
+    if (mode != NULL)
+    {
+        generator_argv[argc++] = mode;
+    }
+    generator_argv[argc] = NULL;
+
+    // flush stdout, so that buffered output of the supervisor does not get duplicated by the generator
+    fflush(stdout);
+
+    pid[index] = fork();
+
+    switch (pid[index])
+    {
+    case -1:
+        fprintf(stderr, "%s Cannot fork: %s\n", argv[0], strerror(errno));
+        return false;
+
+    // child tasks
+    case 0:
+    {
+        // pin generator to one core
+        pin_generator(index, argv);
+
+        // generators should not print their debug output to the output of the supervisor
+        if (freopen("/dev/null", "w", stdout) == NULL)
+        {
+            fprintf(stderr, "%s Cannot redirect stdout: %s\n", argv[0], strerror(errno));
+        }
+        execv(generator_path, generator_argv);
+        fprintf(stderr, "%s Unable to execv %s: %s\n", argv[0], generator_path, strerror(errno));
+        _exit(EXEC_FAILED);
+    }
+
+    // parent tasks
+    default:
+        return true;
+    }
+}
+
+/**
+ * @brief Releases the semaphores which were held by a crashed generator, based on the stage of the writer
+ *
+ * @param crashed the process id of the crashed generator
+ */
+static void release_writer(pid_t crashed)
+{
+    if (buff->writer.pid != crashed)
+        return;
+
+    switch (buff->writer.stage)
+    {
+    // slot was taken but not written --> give slot back
+    case 2:
+        sem_post(free_sem);
+        break;
+
+    // element was written but not announced --> announce it
+    case 3:
+        sem_post(used_sem);
+        break;
+
+    default:
+        break;
+    }
+
+    buff->writer.pid = 0;
+    buff->writer.stage = 0;
+    sem_post(blocked_sem);
+}
+
+/**
+ * @brief Reaps all terminated generators of the pool; releases the semaphores if a generator crashed while writing
+ *        and restarts generators which crashed (as long as the supervisor is running)
+ *
+ * @param number_generators the number of generators in the pool
+ * @param pid array where the process ids of the generators are stored
+ * @param instance the instance name or NULL
+ * @param exact_index the index of the generator in exact mode (or -1)
+ * @param mode option of the mode of the heuristic generators or NULL
+ * @param argv simple hand over of program name argv[0] for error messages
+ */
+static void restart_generators(int number_generators, pid_t pid[], char *instance, int exact_index, char *mode, char *argv[])
+{
+    child_exited = 0;
+
+    int status;
+    pid_t crashed;
+    while ((crashed = waitpid(-1, &status, WNOHANG)) > 0)
+    {
+        release_writer(crashed);
+
+        for (int i = 0; i < number_generators; i++)
+        {
+            if (pid[i] != crashed)
+                continue;
+
+            pid[i] = 0;
+
+            // a generator which cannot be started would crash again and again; a generator which terminated
+            // successfully (exact mode) is finished
+            if (WIFEXITED(status) && WEXITSTATUS(status) == EXEC_FAILED)
+            {
+                fprintf(stderr, "%s Generator %d could not be started!\n", argv[0], i);
+            }
+            // the minimal solution is known but does not fit into the circular buffer --> nothing better can come
+            else if (WIFEXITED(status) && WEXITSTATUS(status) == EXACT_TOO_MANY_EDGES)
+            {
+                printf("%s Minimal solution has %d > 8 edges!\n", argv[0], buff->exact_edges);
+                buff->state = false;
+            }
+            else if (buff->state && !(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS))
+            {
+                fprintf(stderr, "%s Generator %d terminated unexpectedly; restarting it\n", argv[0], i);
+                start_generator(i, pid, instance, i == exact_index ? "-e" : mode, argv);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Stops the generators of the pool; wakes up generators which are waiting for free space in
+ *        the circular buffer (so that they can see that 'state' is false) and waits for them
+ *
+ * @param number_generators the number of generators which got started
+ * @param pid array where the process ids of the generators are stored
+ * @param argv simple hand over of program name argv[0] for error messages
+ */
+static void stop_generators(int number_generators, pid_t pid[], char *argv[])
+{
+    buff->state = false;
+
+    for (int i = 0; i < number_generators; i++)
+    {
+        sem_post(free_sem);
+    }
+
+    for (int i = 0; i < number_generators; i++)
+    {
+        if (pid[i] <= 0)
+            continue;
+
+        while (waitpid(pid[i], NULL, 0) == -1)
+        {
+            if (errno != EINTR)
+            {
+                fprintf(stderr, "%s Error while waiting for generator: %s\n", argv[0], strerror(errno));
+                break;
+            }
+        }
+    }
+}
+
 /**
  * @brief Sets up signal handling; checks correct program call; reads data from the circular buffer
  *        and saves and prints best solution to standard output; calls appropriate functions to make the
@@ -150,10 +399,81 @@ static void shm_sem_setup(char *argv[])
  */
 int main(int argc, char *argv[])
 {
-    // check if arguments specified
-    if (argc > 1)
+    char *instance = NULL;
+    long number_generators = 0;
+    bool exact = false;
+    char *mode = NULL;
+
+    // get options
+    int c;
+    while ((c = getopt(argc, argv, "n:l:eg")) != -1)
+    {
+        char *end_char;
+        switch (c)
+        {
+        case 'g':
+            if (mode != NULL)
+                usage(argv[0]);
+            mode = "-g";
+            break;
+        case 'e':
+            if (exact)
+                usage(argv[0]);
+            exact = true;
+            break;
+        case 'n':
+            if (instance != NULL)
+                usage(argv[0]);
+            instance = optarg;
+            break;
+        case 'l':
+            if (number_generators != 0)
+                usage(argv[0]);
+            number_generators = strtol(optarg, &end_char, 10);
+            if (*end_char != '\0' || number_generators < 1 || number_generators > MAX_GENERATORS)
+                usage(argv[0]);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    // edges are only allowed (and needed) if the generator pool is used
+    if ((number_generators == 0) != (argc - optind == 0) || ((exact || mode != NULL) && number_generators == 0))
+        usage(argv[0]);
+
+    // parse the graph which gets passed to the generators of the pool through the shared memory
+    int number_edges = 0;
+    char *input = NULL;
+    if (number_generators > 0)
     {
-        fprintf(stderr, "%s No arguments allowed!\n", argv[0]);
+        input = join_edges(argc - optind, &argv[optind], &argv[0]);
+        number_edges = count_edges(input);
+        if (number_edges > MAX_EDGES)
+        {
+            fprintf(stderr, "%s Too many edges! At most %d edges are allowed\n", argv[0], MAX_EDGES);
+            exit(EXIT_FAILURE);
+        }
+    }
+    long edge[number_edges > 0 ? number_edges : 1][3];
+    int max_vertex = 0;
+    bool weighted = false;
+    if (input != NULL)
+    {
+        max_vertex = create_edges(input, number_edges, edge, &weighted, &argv[0]);
+        free(input);
+    }
+
+    if (exact && max_vertex + 1 > EXACT_MAX_VERTICES)
+    {
+        fprintf(stderr, "%s Exact mode is only possible for at most %d vertices!\n", argv[0], EXACT_MAX_VERTICES);
+        exit(EXIT_FAILURE);
+    }
+
+    // build up names of shm and semaphores of the wanted instance
+    if (!init_ipc_names(instance))
+    {
+        fprintf(stderr, "%s Invalid instance name!\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -165,19 +485,53 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
+    // set signal handler for terminated generators (no SA_RESTART, so that waiting gets interrupted)
+    struct sigaction sa_child = {.sa_handler = handle_child, .sa_flags = SA_NOCLDSTOP};
+    if (number_generators > 0 && sigaction(SIGCHLD, &sa_child, NULL) < 0)
+    {
+        fprintf(stderr, "%s Error while initializing signal handler: %s\n", argv[0], strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
     // setup shm and semaphores
     shm_sem_setup(&argv[0]);
 
     // init readin position
     int rd_pos = 0;
 
-    // set best number of edges greater than max (== 8)
-    int best_number_edges = 9;
+    // set best cost greater than max (no solution yet)
+    uint64_t best_cost = UINT64_MAX;
 
     // set state to up
     buff->state = true;
     buff->wr_pos = 0;
+    buff->exact_edges = 0;
+    buff->best_cost = best_cost;
     bool cancel = false;
+
+    // write graph to shm and start generator pool (if wanted)
+    buff->graph.number_edges = number_edges;
+    buff->graph.max_vertex = max_vertex;
+    buff->graph.weighted = weighted;
+    memcpy(buff->graph.edge, edge, number_edges * sizeof(edge[0]));
+
+    // the generator in exact mode gets started additionally (on the next core after the heuristic generators)
+    int exact_index = exact ? number_generators : -1;
+    if (exact)
+    {
+        number_generators++;
+    }
+
+    pid_t pid[MAX_GENERATORS + 1];
+    for (int i = 0; i < number_generators; i++)
+    {
+        if (!start_generator(i, pid, instance, i == exact_index ? "-e" : mode, &argv[0]))
+        {
+            number_generators = i;
+            break;
+        }
+    }
+
     while (buff->state)
     {
         // check for state=false again
@@ -186,15 +540,52 @@ int main(int argc, char *argv[])
             break;
         }
 
-        if (sem_wait(used_sem) == -1)
+        // reap and restart crashed generators of the pool
+        if (child_exited)
+        {
+            restart_generators(number_generators, pid, instance, exact_index, mode, &argv[0]);
+
+            // the generator in exact mode can finish the supervisor too
+            if (!buff->state)
+            {
+                break;
+            }
+        }
+
+        // with a generator pool only wait for a limited time, so that crashed generators get noticed
+        int waited;
+        if (number_generators > 0)
+        {
+            struct timespec timeout;
+            clock_gettime(CLOCK_REALTIME, &timeout);
+            timeout.tv_nsec += 100000000;
+            if (timeout.tv_nsec >= 1000000000)
+            {
+                timeout.tv_sec++;
+                timeout.tv_nsec -= 1000000000;
+            }
+            waited = sem_timedwait(used_sem, &timeout);
+        }
+        else
+        {
+            waited = sem_wait(used_sem);
+        }
+
+        if (waited == -1)
         {
             // error message if errno is not interrupt
-            if (errno != EINTR)
+            if (errno != EINTR && errno != ETIMEDOUT)
             {
                 fprintf(stderr, "%s Error while semaphore is waiting: %s\n", argv[0], strerror(errno));
                 exit(EXIT_FAILURE);
             }
 
+            // nothing to read yet or interrupted by a terminated generator
+            if (buff->state)
+            {
+                continue;
+            }
+
             // true if "cancelled" program with SIGINT
             cancel = true;
         }
@@ -202,28 +593,39 @@ int main(int argc, char *argv[])
         // create object of current element in circular buffer
         struct element el = buff->buffer[rd_pos];
 
-        // compares current best number of edges with number of edges of current element which is
-        // stored in circular buffer
+        // compares current best cost with cost of current element which is stored in circular buffer;
+        // without weights the cost is the number of edges
 
-        // only compare if not canceled with SIGINT
-        if (el.edge_number < best_number_edges && !cancel)
+        // only compare if not canceled with SIGINT; a solution of the exact mode is always minimal
+        if ((el.cost < best_cost || el.optimal) && !cancel)
         {
-            best_number_edges = el.edge_number;
+            best_cost = el.cost;
+            buff->best_cost = best_cost;
 
             // print that graph is acyclic if best number of edges is zero
-            if (best_number_edges == 0)
+            if (el.edge_number == 0)
             {
                 printf("%s This graph is already acyclic!\n", argv[0]);
                 buff->state = false;
             }
-            // print solution of current element if number of edges is greater than zero
+            // print solution of current element if number of edges is greater than zero; stop if it is minimal
             else
             {
-                printf("%s Solution with %d edges: ", argv[0], best_number_edges);
-                for (int i = 0; i < best_number_edges; i++)
+                printf("%s %s with %d edges: ", argv[0], el.optimal ? "Minimal solution" : "Solution", el.edge_number);
+                if (el.optimal)
+                {
+                    buff->state = false;
+                }
+                for (int i = 0; i < el.edge_number; i++)
                 {
                     printf("%ld-%ld ", el.fb_arc_set[i].vertex_u, el.fb_arc_set[i].vertex_v); 
                 }
+
+                // only print cost of weighted graphs (generators with their own edges set the flag too)
+                if (buff->graph.weighted)
+                {
+                    printf("(cost %llu)", (unsigned long long)el.cost);
+                }
                 printf("\n");
             }
         }
@@ -233,6 +635,9 @@ int main(int argc, char *argv[])
         rd_pos++;
         rd_pos %= BUFFER_SIZE;
     }
+    // stop generators of the pool
+    stop_generators(number_generators, pid, &argv[0]);
+
     // call function for cleanup process
     cleanup_shm_sem(6, EXIT_SUCCESS, &argv[0]);
 
@@ -0,0 +1,393 @@
+/**
+ * @file bench.c
+ * @author Florian Fürst (12122096)
+ * @brief benchmark of intmul: multiplies random factors from 1 up to 10^6 digits with every strategy of intmul,
+ *        checks every product independently (modulo two primes, computed directly from the hexadecimal strings)
+ *        and prints the time per product as CSV (digits,strategy,seconds,verified) to stdout
+ * @date 2022-12-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <getopt.h>
+#include <time.h>
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+/**
+ * @brief default max number of digits of the factors
+ *
+ */
+#define DEFAULT_MAX_DIGITS (1000000)
+
+/**
+ * @brief default number of seconds after which a strategy does not get measured with larger factors any more
+ *
+ */
+#define DEFAULT_TIME_LIMIT (10.0)
+
+/**
+ * @brief the primes of the check: 2^61 - 1 and 2^64 - 2^32 + 1
+ *
+ */
+static const uint64_t checkPrimes[2] = {0x1fffffffffffffffULL, 0xffffffff00000001ULL};
+
+/**
+ * @brief a strategy of intmul: its name in the CSV and its options
+ *
+ */
+struct strategy
+{
+    const char *name;
+    char *arguments[8];
+};
+
+static struct strategy strategies[] = {
+    {"process", {"./intmul", "-m", "process", NULL}},
+    {"fork", {"./intmul", "-m", "fork", NULL}},
+    {"fork-karatsuba", {"./intmul", "-m", "fork", "-k", NULL}},
+    {"thread", {"./intmul", "-m", "thread", "-n", "0", NULL}},
+    {"thread-karatsuba", {"./intmul", "-m", "thread", "-k", "-n", "0", NULL}},
+    {"ntt", {"./intmul", "-m", "thread", "-n", "1", NULL}},
+};
+
+#define STRATEGY_COUNT (sizeof(strategies) / sizeof(strategies[0]))
+
+/**
+ * @brief Prints the correct usage(synopsis) of the program to stderr and exits
+ *
+ * @param name the program name argv[0]
+ */
+static void usage(char *name)
+{
+    fprintf(stderr, "SYNOPSIS:\n%s [-d MAX_DIGITS] [-l TIME_LIMIT]\n", name);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief returns the current time in seconds (monotonic clock)
+ *
+ * @return double the current time
+ */
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/**
+ * @brief returns the next pseudo-random number (xorshift64, so that the factors are the same on every host)
+ *
+ * @param state the state of the generator
+ * @return uint64_t the random number
+ */
+static uint64_t nextRandom(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+ * @brief writes a random hexadecimal integer (without leading zero) and a newline into the buffer
+ *
+ * @param buffer the buffer (digits + 1 chars)
+ * @param digits the number of digits
+ * @param state the state of the random generator
+ */
+static void randomHex(char *buffer, size_t digits, uint64_t *state)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    for (size_t i = 0; i < digits; i++)
+    {
+        buffer[i] = hexDigits[nextRandom(state) % 16];
+    }
+    if (buffer[0] == '0')
+        buffer[0] = '1';
+
+    buffer[digits] = '\n';
+}
+
+/**
+ * @brief calculates a hexadecimal integer modulo the prime (horner's method, one digit after another)
+ *
+ * @param hex the digits
+ * @param digits the number of digits
+ * @param prime the prime
+ * @return uint64_t the remainder
+ */
+static uint64_t hexModulo(const char *hex, size_t digits, uint64_t prime)
+{
+    uint64_t remainder = 0;
+
+    for (size_t i = 0; i < digits; i++)
+    {
+        char c = hex[i];
+        uint64_t digit = c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+
+        remainder = ((uint128_t)remainder * 16 + digit) % prime;
+    }
+
+    return remainder;
+}
+
+/**
+ * @brief checks the product of intmul: it must have twice as many digits as the longer factor filled up to a power
+ *        of two, and it must be equal to the product of the factors modulo both primes
+ *
+ * @param product the output of intmul (with newline)
+ * @param length the number of chars of the output
+ * @param input the two factors (each with newline)
+ * @param digits the number of digits of each factor
+ * @return true if the product is correct
+ * @return false otherwise
+ */
+static bool verify(const char *product, size_t length, const char *input, size_t digits)
+{
+    size_t expected = 1;
+    while (expected < digits)
+    {
+        expected *= 2;
+    }
+
+    if (length != 2 * expected + 1 || product[2 * expected] != '\n')
+        return false;
+
+    for (int p = 0; p < 2; p++)
+    {
+        uint64_t prime = checkPrimes[p];
+        uint64_t a = hexModulo(input, digits, prime);
+        uint64_t b = hexModulo(input + digits + 1, digits, prime);
+
+        if ((uint128_t)a * b % prime != hexModulo(product, 2 * expected, prime))
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief runs intmul with the strategy: the input gets written to its stdin, its stdout gets read into output
+ *
+ * @param strategy the strategy
+ * @param input the input (two factors)
+ * @param inputLength the number of chars of the input
+ * @param output the buffer of the output (grows if needed)
+ * @param outputSize the size of the buffer
+ * @param outputLength the number of chars which were read
+ * @param argv simple hand over of program name argv[0] for error messages
+ * @return true if intmul exited successfully
+ * @return false otherwise
+ */
+static bool runIntmul(struct strategy *strategy, const char *input, size_t inputLength, char **output,
+                      size_t *outputSize, size_t *outputLength, char *argv)
+{
+    int inPipe[2], outPipe[2];
+
+    if (pipe(inPipe) == -1 || pipe(outPipe) == -1)
+    {
+        fprintf(stderr, "%s Cannot create pipe! %s\n", argv, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    pid_t pid = fork();
+    switch (pid)
+    {
+    case -1:
+        fprintf(stderr, "%s Cannot fork!\n", argv);
+        exit(EXIT_FAILURE);
+        break;
+
+    // child tasks
+    case 0:
+        close(inPipe[1]);
+        close(outPipe[0]);
+
+        if (dup2(inPipe[0], STDIN_FILENO) == -1 || dup2(outPipe[1], STDOUT_FILENO) == -1)
+        {
+            fprintf(stderr, "%s Cannot redirect pipe!\n", argv);
+            exit(EXIT_FAILURE);
+        }
+
+        close(inPipe[0]);
+        close(outPipe[1]);
+
+        execv("./intmul", strategy->arguments);
+        fprintf(stderr, "%s Unable to execv\n", argv);
+        exit(EXIT_FAILURE);
+        break;
+
+    // parent tasks
+    default:
+        break;
+    }
+
+    close(inPipe[0]);
+    close(outPipe[1]);
+
+    // intmul reads the whole input before it writes the product, so the input can be written at once
+    bool written = true;
+    for (size_t position = 0; position < inputLength;)
+    {
+        ssize_t bytes = write(inPipe[1], input + position, inputLength - position);
+        if (bytes == -1 && errno == EINTR)
+            continue;
+
+        if (bytes == -1)
+        {
+            written = false;
+            break;
+        }
+        position += bytes;
+    }
+    close(inPipe[1]);
+
+    *outputLength = 0;
+    while (true)
+    {
+        if (*outputLength == *outputSize)
+        {
+            *outputSize = *outputSize > 0 ? 2 * *outputSize : 4096;
+            *output = realloc(*output, *outputSize);
+            if (*output == NULL)
+            {
+                fprintf(stderr, "%s Cannot allocate memory!\n", argv);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        ssize_t bytes = read(outPipe[0], *output + *outputLength, *outputSize - *outputLength);
+        if (bytes == -1 && errno == EINTR)
+            continue;
+
+        if (bytes <= 0)
+            break;
+
+        *outputLength += bytes;
+    }
+    close(outPipe[0]);
+
+    int status;
+    while (waitpid(pid, &status, 0) == -1)
+    {
+        if (errno != EINTR)
+        {
+            fprintf(stderr, "%s Error while waiting for child\n", argv);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return written && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+/**
+ * @brief measures every strategy for factors of 1, 2, 5, 10, 20, 50, ... digits up to the max number of digits;
+ *        a strategy which needed longer than the time limit does not get measured with larger factors
+ *
+ * @param argc number of arguments of the program call
+ * @param argv array of the arguments of the program call
+ * @return int EXIT_SUCCESS if all products were correct, EXIT_FAILURE otherwise
+ */
+int main(int argc, char *argv[])
+{
+    long maxDigits = DEFAULT_MAX_DIGITS;
+    double timeLimit = DEFAULT_TIME_LIMIT;
+
+    int c;
+    char *endChar;
+    while ((c = getopt(argc, argv, "d:l:")) != -1)
+    {
+        switch (c)
+        {
+        case 'd':
+            maxDigits = strtol(optarg, &endChar, 10);
+            if (*endChar != '\0' || maxDigits < 1)
+            {
+                usage(argv[0]);
+            }
+            break;
+        case 'l':
+            timeLimit = strtod(optarg, &endChar);
+            if (*endChar != '\0' || timeLimit <= 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (argc - optind > 0)
+    {
+        usage(argv[0]);
+    }
+
+    // intmul gets killed by SIGPIPE if it does not read its input, the benchmark reports that as failure instead
+    signal(SIGPIPE, SIG_IGN);
+
+    char *input = malloc(2 * (maxDigits + 1));
+    if (input == NULL)
+    {
+        fprintf(stderr, "%s Cannot allocate memory!\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    char *output = NULL;
+    size_t outputSize = 0, outputLength;
+    bool stopped[STRATEGY_COUNT] = {false};
+    bool allCorrect = true;
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+    fprintf(stdout, "digits,strategy,seconds,verified\n");
+    fflush(stdout);
+
+    static const long steps[] = {1, 2, 5};
+    for (long decade = 1; decade <= maxDigits; decade *= 10)
+    {
+        for (int step = 0; step < 3 && decade * steps[step] <= maxDigits; step++)
+        {
+            size_t digits = decade * steps[step];
+
+            randomHex(input, digits, &state);
+            randomHex(input + digits + 1, digits, &state);
+
+            for (size_t s = 0; s < STRATEGY_COUNT; s++)
+            {
+                if (stopped[s])
+                    continue;
+
+                double start = now();
+                bool success = runIntmul(&strategies[s], input, 2 * (digits + 1), &output, &outputSize, &outputLength,
+                                         argv[0]);
+                double seconds = now() - start;
+
+                bool verified = success && verify(output, outputLength, input, digits);
+                allCorrect = allCorrect && verified;
+
+                fprintf(stdout, "%zu,%s,%.6f,%s\n", digits, strategies[s].name, seconds, verified ? "yes" : "no");
+                fflush(stdout);
+
+                stopped[s] = seconds > timeLimit;
+            }
+        }
+    }
+
+    free(input);
+    free(output);
+
+    return allCorrect ? EXIT_SUCCESS : EXIT_FAILURE;
+}
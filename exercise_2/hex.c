@@ -0,0 +1,370 @@
+/**
+ * @file hex.c
+ * @author Florian Fürst (12122096)
+ * @brief bulk conversion between hexadecimal strings and limbs: 16 digits (one limb) get validated, decoded or
+ *        encoded at once with SSE2, 32 digits with AVX2 if the processor supports it; a scalar loop handles the
+ *        remaining digits and other processors
+ * @date 2022-12-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "hex.h"
+
+#if defined(__x86_64__) && defined(__SSE2__)
+#define HEX_SIMD
+#include <immintrin.h>
+#endif
+
+static const char hexDigits[] = "0123456789abcdef";
+
+/**
+ * @brief checks if the char is a valid hexadecimal digit
+ *
+ * @param hex the char
+ * @return true if it is a digit, 'a'-'f' or 'A'-'F'
+ * @return false otherwise
+ */
+static bool isHexDigit(char hex)
+{
+    return (hex >= '0' && hex <= '9') || (hex >= 'a' && hex <= 'f') || (hex >= 'A' && hex <= 'F');
+}
+
+/**
+ * @brief converts a hexadecimal char to an integer (the char has to be a valid hexadecimal digit)
+ *
+ * @param hex the hexadecimal char
+ * @return limb_t the converted integer
+ */
+static limb_t hexValue(char hex)
+{
+    if (hex >= 'a' && hex <= 'f')
+        return hex - 'a' + 10;
+    if (hex >= 'A' && hex <= 'F')
+        return hex - 'A' + 10;
+    return hex - '0';
+}
+
+/**
+ * @brief converts up to 16 digits (most significant digit first) to one limb
+ *
+ * @param hex the digits
+ * @param length the number of digits
+ * @return limb_t the limb
+ */
+static limb_t scalarDecode(const char *hex, size_t length)
+{
+    limb_t limb = 0;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        limb = (limb << 4) | hexValue(hex[i]);
+    }
+
+    return limb;
+}
+
+/**
+ * @brief converts one limb to exactly the given number of digits (at most 16)
+ *
+ * @param hex the array where the digits get written into
+ * @param limb the limb
+ * @param digits the number of digits
+ */
+static void scalarEncode(char hex[], limb_t limb, size_t digits)
+{
+    for (size_t i = 0; i < digits; i++)
+    {
+        hex[digits - 1 - i] = hexDigits[(limb >> (4 * i)) & 0xf];
+    }
+}
+
+#ifdef HEX_SIMD
+
+/**
+ * @brief checks if the processor supports AVX2 (only checked once)
+ *
+ * @return true if AVX2 is supported
+ * @return false otherwise
+ */
+static bool hasAvx2(void)
+{
+    static int avx2 = -1;
+
+    if (avx2 == -1)
+    {
+        __builtin_cpu_init();
+        avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+
+    return avx2 == 1;
+}
+
+/**
+ * @brief returns a mask with 0xff for every byte of the 16 chars which is a valid hexadecimal digit
+ *
+ * @param chars the chars
+ * @return __m128i the mask
+ */
+static __m128i validMask128(__m128i chars)
+{
+    // setting bit 0x20 maps 'A'-'F' to 'a'-'f'; bytes >= 0x80 are negative and therefore never in a range
+    __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                   _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+
+    return _mm_or_si128(digit, letter);
+}
+
+/**
+ * @brief converts 16 valid digits (most significant digit first) to one limb
+ *
+ * @param hex the digits
+ * @return limb_t the limb
+ */
+static limb_t decode128(const char *hex)
+{
+    __m128i chars = _mm_loadu_si128((const __m128i *)hex);
+    __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+
+    // '0'-'9' -> 0-9 and 'a'-'f' -> 10-15 ('a' - '0' - 10 = 39)
+    __m128i letter = _mm_cmpgt_epi8(lower, _mm_set1_epi8('9'));
+    __m128i nibbles = _mm_sub_epi8(_mm_sub_epi8(lower, _mm_set1_epi8('0')),
+                                   _mm_and_si128(letter, _mm_set1_epi8(39)));
+
+    // every 16-bit word contains two digits: the first one (more significant) in the lower byte
+    __m128i high = _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00ff)), 4);
+    __m128i low = _mm_srli_epi16(nibbles, 8);
+    __m128i bytes = _mm_packus_epi16(_mm_or_si128(high, low), _mm_setzero_si128());
+
+    // the first byte is the most significant one
+    return __builtin_bswap64((limb_t)_mm_cvtsi128_si64(bytes));
+}
+
+/**
+ * @brief converts one limb to 16 digits (most significant digit first)
+ *
+ * @param hex the array where the digits get written into
+ * @param limb the limb
+ */
+static void encode128(char hex[], limb_t limb)
+{
+    __m128i bytes = _mm_cvtsi64_si128((long long)__builtin_bswap64(limb));
+
+    // the upper nibble of every byte is the first digit
+    __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0f));
+    __m128i low = _mm_and_si128(bytes, _mm_set1_epi8(0x0f));
+    __m128i nibbles = _mm_unpacklo_epi8(high, low);
+
+    // 0-9 -> '0'-'9' and 10-15 -> 'a'-'f'
+    __m128i letter = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+    __m128i chars = _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+                                 _mm_and_si128(letter, _mm_set1_epi8(39)));
+
+    _mm_storeu_si128((__m128i *)hex, chars);
+}
+
+/**
+ * @brief returns the index of the first invalid char of the 32 chars (32 if all chars are valid)
+ *
+ * @param hex the chars
+ * @return size_t the index
+ */
+__attribute__((target("avx2"))) static size_t validate256(const char *hex)
+{
+    __m256i chars = _mm256_loadu_si256((const __m256i *)hex);
+    __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars));
+    __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                      _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+
+    unsigned int valid = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(digit, letter));
+
+    return valid == 0xffffffffu ? 32 : (size_t)__builtin_ctz(~valid);
+}
+
+/**
+ * @brief converts 32 valid digits to two limbs: the first 16 digits are the more significant limb
+ *
+ * @param limbs the array where the limbs get written into (limbs[0] = last 16 digits, limbs[1] = first 16 digits)
+ * @param hex the digits
+ */
+__attribute__((target("avx2"))) static void decode256(limb_t limbs[], const char *hex)
+{
+    __m256i chars = _mm256_loadu_si256((const __m256i *)hex);
+    __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+
+    __m256i letter = _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('9'));
+    __m256i nibbles = _mm256_sub_epi8(_mm256_sub_epi8(lower, _mm256_set1_epi8('0')),
+                                      _mm256_and_si256(letter, _mm256_set1_epi8(39)));
+
+    __m256i high = _mm256_slli_epi16(_mm256_and_si256(nibbles, _mm256_set1_epi16(0x00ff)), 4);
+    __m256i low = _mm256_srli_epi16(nibbles, 8);
+
+    // packing works per 128-bit lane, so every lane contains the 8 bytes of one limb in its lower half
+    __m256i bytes = _mm256_packus_epi16(_mm256_or_si256(high, low), _mm256_setzero_si256());
+
+    limbs[1] = __builtin_bswap64((limb_t)_mm256_extract_epi64(bytes, 0));
+    limbs[0] = __builtin_bswap64((limb_t)_mm256_extract_epi64(bytes, 2));
+}
+
+/**
+ * @brief converts two limbs to 32 digits: the more significant limb gets written first
+ *
+ * @param hex the array where the digits get written into
+ * @param high the more significant limb
+ * @param low the less significant limb
+ */
+__attribute__((target("avx2"))) static void encode256(char hex[], limb_t high, limb_t low)
+{
+    __m256i bytes = _mm256_set_epi64x(0, (long long)__builtin_bswap64(low), 0, (long long)__builtin_bswap64(high));
+
+    __m256i upper = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0x0f));
+    __m256i lowerNibbles = _mm256_and_si256(bytes, _mm256_set1_epi8(0x0f));
+    __m256i nibbles = _mm256_unpacklo_epi8(upper, lowerNibbles);
+
+    __m256i letter = _mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9));
+    __m256i chars = _mm256_add_epi8(_mm256_add_epi8(nibbles, _mm256_set1_epi8('0')),
+                                    _mm256_and_si256(letter, _mm256_set1_epi8(39)));
+
+    _mm256_storeu_si256((__m256i *)hex, chars);
+}
+
+#endif
+
+/**
+ * @brief returns the index of the first char which is not a valid hexadecimal digit
+ *
+ * @param hex the chars
+ * @param length the number of chars
+ * @return size_t the index of the first invalid char (length if all chars are valid)
+ */
+size_t hexValidate(const char *hex, size_t length)
+{
+    size_t i = 0;
+
+#ifdef HEX_SIMD
+    if (hasAvx2())
+    {
+        for (; i + 32 <= length; i += 32)
+        {
+            size_t valid = validate256(hex + i);
+            if (valid < 32)
+                return i + valid;
+        }
+    }
+
+    for (; i + 16 <= length; i += 16)
+    {
+        unsigned int valid = _mm_movemask_epi8(validMask128(_mm_loadu_si128((const __m128i *)(hex + i))));
+        if (valid != 0xffff)
+            return i + __builtin_ctz(~valid);
+    }
+#endif
+
+    for (; i < length; i++)
+    {
+        if (!isHexDigit(hex[i]))
+            return i;
+    }
+
+    return length;
+}
+
+/**
+ * @brief converts a valid hexadecimal string (most significant digit first) to limbs
+ *
+ * @param limbs the array where the limbs get written into (LIMBS_FOR_DIGITS(length) limbs)
+ * @param hex the hexadecimal string
+ * @param length the number of digits of the string
+ * @return size_t the number of written limbs
+ */
+size_t limbsFromHex(limb_t limbs[], const char *hex, size_t length)
+{
+    size_t count = LIMBS_FOR_DIGITS(length);
+    size_t full = length / LIMB_DIGITS;
+    size_t i = 0;
+
+    // limb i consists of the digits [length - 16 * (i + 1), length - 16 * i)
+#ifdef HEX_SIMD
+    if (hasAvx2())
+    {
+        for (; i + 2 <= full; i += 2)
+        {
+            decode256(limbs + i, hex + length - (i + 2) * LIMB_DIGITS);
+        }
+    }
+
+    for (; i < full; i++)
+    {
+        limbs[i] = decode128(hex + length - (i + 1) * LIMB_DIGITS);
+    }
+#endif
+
+    for (; i < full; i++)
+    {
+        limbs[i] = scalarDecode(hex + length - (i + 1) * LIMB_DIGITS, LIMB_DIGITS);
+    }
+
+    // the most significant limb can have less digits
+    if (full < count)
+    {
+        limbs[full] = scalarDecode(hex, length - full * LIMB_DIGITS);
+    }
+
+    return count;
+}
+
+/**
+ * @brief converts limbs to a hexadecimal string with exactly the given number of digits (lower case, filled up with
+ *        leading zeros); the string gets terminated with '\0'
+ *
+ * @param hex the array where the string gets written into (digits + 1 chars)
+ * @param limbs the limbs which get converted
+ * @param limbCount the number of limbs
+ * @param digits the number of digits of the string
+ */
+void limbsToHex(char hex[], const limb_t limbs[], size_t limbCount, size_t digits)
+{
+    size_t full = digits / LIMB_DIGITS;
+    size_t i = 0;
+
+    // limb i gets written to the digits [digits - 16 * (i + 1), digits - 16 * i)
+#ifdef HEX_SIMD
+    if (hasAvx2())
+    {
+        for (; i + 2 <= full && i + 2 <= limbCount; i += 2)
+        {
+            encode256(hex + digits - (i + 2) * LIMB_DIGITS, limbs[i + 1], limbs[i]);
+        }
+    }
+
+    for (; i < full && i < limbCount; i++)
+    {
+        encode128(hex + digits - (i + 1) * LIMB_DIGITS, limbs[i]);
+    }
+#endif
+
+    for (; i < full && i < limbCount; i++)
+    {
+        scalarEncode(hex + digits - (i + 1) * LIMB_DIGITS, limbs[i], LIMB_DIGITS);
+    }
+
+    // leading zeros beyond the limbs
+    memset(hex, '0', digits - (i < full ? i : full) * LIMB_DIGITS);
+
+    // the most significant digits can be only a part of a limb
+    if (i == full && full * LIMB_DIGITS < digits)
+    {
+        scalarEncode(hex, full < limbCount ? limbs[full] : 0, digits - full * LIMB_DIGITS);
+    }
+
+    hex[digits] = '\0';
+}
@@ -0,0 +1,23 @@
+/**
+ * @file hex.h
+ * @author Florian Fürst (12122096)
+ * @brief declares the bulk conversion between hexadecimal strings and limbs (vectorized with SSE2/AVX2 on x86,
+ *        scalar otherwise) which is used for the input and output of intmul
+ * @date 2022-12-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef HEX_H
+#define HEX_H
+
+#include <stddef.h>
+
+#include "limb.h"
+
+size_t hexValidate(const char *hex, size_t length);
+size_t limbsFromHex(limb_t limbs[], const char *hex, size_t length);
+void limbsToHex(char hex[], const limb_t limbs[], size_t limbCount, size_t digits);
+
+#endif
@@ -1,7 +1,10 @@
 /**
  * @file intmul.c
  * @author Florian Fürst (12122096)
- * @brief multiplies two hexadecimal integers using fork and pipes
+ * @brief multiplies two hexadecimal integers (or integers of any other base from 2 to 36) using fork (with or
+ *        without exec) or a pool of threads (optionally with karatsuba); the input gets converted to 64-bit limbs
+ *        once, the children read their factors from and write their products into shared memory and the product
+ *        gets converted back to the output base only once
  * @version 0.1
  * @date 2022-12-11
  *
@@ -14,202 +17,294 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
-#include <ctype.h>
 #include <unistd.h>
 #include <errno.h>
 #include <sys/wait.h>
+#include <signal.h>
+#include <getopt.h>
+#include <time.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "limb.h"
+#include "ntt.h"
+#include "hex.h"
+#include "radix.h"
+#include "modexp.h"
 
-int outPipe[4][2];
-int childindex[4];
+/**
+ * @brief default number of digits up to which the product gets calculated in-process (without forking)
+ *
+ */
+#define DEFAULT_THRESHOLD (256)
+
+/**
+ * @brief default number of digits from which on the product gets calculated with the number-theoretic transform
+ *
+ */
+#define DEFAULT_NTT_THRESHOLD (262144)
+
+/**
+ * @brief max number of shared memory regions which are mapped by one process at the same time
+ *
+ */
+#define MAX_REGIONS (16)
 
 int forks = 0;
 
 /**
- * @brief adds leading zeros to A and B if A and B have not the equal length or the number of digits is not a power of two
+ * @brief arguments of the children (the same options as the parent; e.g. "-k" for karatsuba); the children
+ *        additionally get "-r" with the positions of their factors and their product in shared memory and their
+ *        budget of processes
+ *
+ */
+char *childArgv[10];
+char thresholdArgument[32];
+char nttThresholdArgument[32];
+char referenceArgument[128];
+
+/**
+ * @brief a shared memory object which is mapped by this process: its file descriptor (which gets inherited by the
+ *        children), the mapping and its number of limbs
  *
- * @param correctFirstInput char array of first valid input
- * @param correctSecondInput char array of second valid input
- * @param firstHexInt string of first non valid input
- * @param secondHexInt string of second non valid input
- * @param neededLength the length of the valid strings
  */
-static void inputCorrection(char correctFirstInput[], char correctSecondInput[],
-                            char *firstHexInt, char *secondHexInt, int neededLength)
+struct region
 {
-    int lenFirst = strlen(firstHexInt);
-    int lenSecond = strlen(secondHexInt);
+    int fd;
+    limb_t *limbs;
+    size_t count;
+};
 
-    for (int i = 0; i < neededLength - lenFirst; i++)
-    {
-        correctFirstInput[i] = '0';
-    }
-    correctFirstInput[neededLength - lenFirst] = '\0';
+/**
+ * @brief a position in shared memory which is valid in the children too: the descriptor of the shared memory
+ *        object and the offset in limbs
+ *
+ */
+struct reference
+{
+    int fd;
+    size_t offset;
+};
 
-    for (int i = 0; i < neededLength - lenSecond; i++)
-    {
-        correctSecondInput[i] = '0';
-    }
-    correctSecondInput[neededLength - lenSecond] = '\0';
+struct region regions[MAX_REGIONS];
+int regionCount = 0;
+int regionNames = 0;
 
-    // build up string
-    strcat(correctFirstInput, firstHexInt);
-    strcat(correctSecondInput, secondHexInt);
+/**
+ * @brief the options of the multiplication
+ *
+ */
+struct options
+{
+    bool karatsuba;
+    long threshold;
+    long nttThreshold;
+    int threads;
+    bool exec;
+    long budget;
+    char *argv;
+    int inputBase;
+    int outputBase;
+};
+
+/**
+ * @brief Prints the correct usage(synopsis) of the program to stderr and exits
+ *
+ * @param name the program name argv[0]
+ */
+static void usage(char *name)
+{
+    fprintf(stderr, "SYNOPSIS:\n%s [-k] [-t THRESHOLD | -a] [-m process|fork|thread] [-j THREADS] [-n NTT_THRESHOLD] "
+                    "[-s | -p] [-f FILE] [-i BASE] [-o BASE]\n",
+            name);
+    exit(EXIT_FAILURE);
 }
 
 /**
- * @brief converts a hexadecimal string to an integer
+ * @brief allocates an array of limbs
  *
- * @param hexInt hexadecimal string
+ * @param count the number of limbs
  * @param argv simple hand over of program name argv[0] for error messages
- * @return int the converted integer
+ * @return limb_t* the array
  */
-static int convertHexToInt(char *hexInt, char *argv)
+static limb_t *allocateLimbs(size_t count, char *argv)
 {
-    int hexAsInt;
+    limb_t *limbs = malloc(count * sizeof(limb_t));
 
-    // convert single hexadecimal integer (char) to int
-    hexAsInt = strtol(hexInt, NULL, 16);
+    if (limbs == NULL)
+    {
+        fprintf(stderr, "%s Cannot allocate memory!\n", argv);
+        exit(EXIT_FAILURE);
+    }
 
-    return hexAsInt;
+    return limbs;
 }
 
 /**
- * @brief converts a hexadecimal char to an integer
+ * @brief maps size limbs of the shared memory object fd and adds the mapping to the regions of this process
  *
- * @param hexInt hexadecimal string
+ * @param fd the file descriptor of the shared memory object
+ * @param count the number of limbs of the object
  * @param argv simple hand over of program name argv[0] for error messages
- * @return int the converted integer
+ * @return limb_t* the mapped limbs
  */
-static int convertSingleHexToInt(char hexInt, char *argv)
+static limb_t *mapRegion(int fd, size_t count, char *argv)
 {
-    int hexAsInt;
-
-    // convert single hexadecimal integer (char) to int
-    if (hexInt >= 'A' && hexInt <= 'F')
-    {
-        hexAsInt = (hexInt - 'A' + 10);
-    }
-    else if (hexInt >= 'a' && hexInt <= 'f')
+    if (regionCount == MAX_REGIONS)
     {
-        hexAsInt = (hexInt - 'a' + 10);
+        fprintf(stderr, "%s Too many shared memory regions!\n", argv);
+        exit(EXIT_FAILURE);
     }
-    else
+
+    limb_t *limbs = mmap(NULL, count * sizeof(limb_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (limbs == MAP_FAILED)
     {
-        hexAsInt = (hexInt - '0');
+        fprintf(stderr, "%s Error while mapping shared memory object: %s\n", argv, strerror(errno));
+        exit(EXIT_FAILURE);
     }
 
-    return hexAsInt;
+    regions[regionCount++] = (struct region){fd, limbs, count};
+
+    return limbs;
 }
 
 /**
- * @brief converts a single integer to hexadecimal char
+ * @brief allocates an array of limbs in a new shared memory object. The object gets unlinked at once (it lives as
+ *        long as its descriptor or a mapping exists), and the descriptor stays open across execv, so that the
+ *        children can map the same limbs
  *
- * @param number the integer which needs to be converted
+ * @param count the number of limbs
  * @param argv simple hand over of program name argv[0] for error messages
- * @return char the converted char
+ * @return limb_t* the array
  */
-static char convertIntToSingleHex(int number, char *argv)
+static limb_t *allocateShared(size_t count, char *argv)
 {
-    number %= 16;
-    char output;
-    // check if input is valid hexadecimal integer
-    if (number < 0 || number > 15)
+    char name[64];
+    snprintf(name, sizeof(name), "/intmul_%ld_%d", (long)getpid(), regionNames++);
+
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_EXCL, 0600);
+    if (fd == -1)
     {
-        fprintf(stderr, "%s Invalid hexadecimal integer! %d\n ", argv, number);
+        fprintf(stderr, "%s Error while creating shared memory object: %s\n", argv, strerror(errno));
         exit(EXIT_FAILURE);
     }
 
-    // convert int to hexadecimal integer (char)
-    if (number >= 10)
-    {
-        output = 'a' + (number - 10);
-    }
-    else
+    // shm_open sets FD_CLOEXEC, but the children need the descriptor after execv
+    if (shm_unlink(name) == -1 || fcntl(fd, F_SETFD, 0) == -1 || ftruncate(fd, count * sizeof(limb_t)) == -1)
     {
-        output = '0' + number;
+        fprintf(stderr, "%s Error while setting up shared memory: %s\n", argv, strerror(errno));
+        exit(EXIT_FAILURE);
     }
 
-    return output;
+    return mapRegion(fd, count, argv);
 }
 
 /**
- * @brief Split the given string in two, equal long, strings
+ * @brief unmaps and closes a region which was allocated with allocateShared
  *
- * @param wholeString the whole string which needs to be splitted
- * @param part_h one half of the string
- * @param part_l one half of the string
- * @param length the length of the whole string
- * @param length_h the length of one string part
- * @param length_l the length of one string part
+ * @param limbs the array of the region
+ * @param argv simple hand over of program name argv[0] for error messages
  */
-static void createHalfStrings(char wholeString[], char part_h[], char part_l[], int length, int length_h, int length_l)
+static void freeShared(limb_t *limbs, char *argv)
 {
-    for (int i = 0; i < length_h; i++)
+    for (int i = 0; i < regionCount; i++)
     {
-        part_h[i] = wholeString[i];
+        if (regions[i].limbs != limbs)
+            continue;
+
+        if (munmap(limbs, regions[i].count * sizeof(limb_t)) == -1 || close(regions[i].fd) == -1)
+        {
+            fprintf(stderr, "%s Error while releasing shared memory: %s\n", argv, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+
+        regions[i] = regions[--regionCount];
+        return;
     }
-    part_h[length_h] = '\0';
+}
 
-    for (int i = 0, x = length_h; i < length_l; i++, x++)
+/**
+ * @brief returns the shared memory position of count limbs starting at pointer
+ *
+ * @param pointer the first limb
+ * @param count the number of limbs
+ * @return struct reference the position; fd is -1 if the limbs are not in a region of this process
+ */
+static struct reference findShared(const limb_t *pointer, size_t count)
+{
+    for (int i = 0; i < regionCount; i++)
     {
-        part_l[i] = wholeString[x];
+        if (pointer >= regions[i].limbs && pointer + count <= regions[i].limbs + regions[i].count)
+        {
+            return (struct reference){regions[i].fd, pointer - regions[i].limbs};
+        }
     }
-    part_l[length_l] = '\0';
+
+    return (struct reference){-1, 0};
 }
 
 /**
- * @brief Method to write values into a pipe
+ * @brief returns the limbs of a reference which a child got from its parent; the inherited shared memory object
+ *        gets mapped on its first use
  *
- * @param fd the file descriptor where values needs to be written
- * @param A char array A, which gets written into pipe
- * @param B char array B, which gets written into pipe
+ * @param reference the position of the limbs
+ * @param count the number of limbs
  * @param argv simple hand over of program name argv[0] for error messages
+ * @return limb_t* the limbs
  */
-static void writeToPipe(int fd, char A[], char B[], char *argv)
+static limb_t *openShared(struct reference reference, size_t count, char *argv)
 {
-    FILE *out = fdopen(fd, "w");
-    fprintf(out, "%s\n", A);
-    fprintf(out, "%s\n", B);
+    int i = 0;
+    while (i < regionCount && regions[i].fd != reference.fd)
+    {
+        i++;
+    }
 
-    fflush(out);
+    if (i == regionCount)
+    {
+        struct stat status;
+        if (fstat(reference.fd, &status) == -1)
+        {
+            fprintf(stderr, "%s Cannot open shared memory of parent: %s\n", argv, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        mapRegion(reference.fd, status.st_size / sizeof(limb_t), argv);
+    }
 
-    if (fclose(out) == EOF)
+    if (reference.offset + count > regions[i].count)
     {
-        fprintf(stderr, "%s Error while closing file! %s\n", argv, strerror(errno));
+        fprintf(stderr, "%s Invalid reference to shared memory of parent\n", argv);
         exit(EXIT_FAILURE);
     }
+
+    return regions[i].limbs + reference.offset;
 }
 
+static void multiplyWithChildren(limb_t product[], const limb_t a[], const limb_t b[], size_t count, void *context);
+
 /**
- * @brief Method to initialize forking and pipe; also calls other method to write into pipe
+ * @brief Method to fork the children; every child gets the positions of its factors and of its result slot in
+ *        shared memory as argument, so nothing gets copied to or from the children. Without exec, the children
+ *        continue the recursion directly in the forked address space (where the shared memory is mapped already)
  *
- * @param A char array A, which gets parsed to children
- * @param B char array B, which gets parsed to children
- * @param length the length of the input string
- * @param argv simple hand over of program name argv[0] for error messages
+ * @param A the first factors (one for each child)
+ * @param B the second factors (one for each child)
+ * @param R the arrays where the children write their products into (2 * count limbs each)
+ * @param count the number of limbs of each factor
+ * @param children the number of children (4 or 3 with karatsuba)
+ * @param budgets the budget of processes of each child
+ * @param options the options of the multiplication
  * @param pid process id for forking
  */
-static void forkAndPipe(char A[], char B[], int length, char *argv, pid_t pid[])
+static void forkChildren(const limb_t *A[], const limb_t *B[], limb_t *R[], size_t count, int children,
+                         const long budgets[], struct options *options, pid_t pid[])
 {
-    int length_h = length / 2;
-    int length_l = length / 2;
-
-    // length + 1 because of \0
-    char Ah[length_h + 1];
-    char Al[length_l + 1];
-    char Bh[length_h + 1];
-    char Bl[length_l + 1];
-
-    createHalfStrings(A, Ah, Al, length, length_h, length_l);
-    createHalfStrings(B, Bh, Bl, length, length_h, length_l);
+    char *argv = options->argv;
 
-    int inPipe[4][2];
-
-    for (int i = 0; i < 4; i++)
+    for (int i = 0; i < children; i++)
     {
-        pipe(inPipe[i]);
-        pipe(outPipe[i]);
-
         forks++;
         pid[i] = fork();
 
@@ -222,199 +317,896 @@ static void forkAndPipe(char A[], char B[], int length, char *argv, pid_t pid[])
 
         // child tasks
         case 0:
-            close(inPipe[i][1]);
-            close(outPipe[i][0]);
-
-            if (dup2(inPipe[i][0], STDIN_FILENO) == -1 || dup2(outPipe[i][1], STDOUT_FILENO) == -1)
+            options->budget = budgets[i];
+            if (!options->exec)
             {
-                fprintf(stderr, "%s Cannot redirect pipe!\n", argv);
-                exit(EXIT_FAILURE);
+                multiplyWithChildren(R[i], A[i], B[i], count, options);
+
+                // _exit: the child must not flush the copies of the stdio buffers of the parent or run its atexit
+                // handlers
+                _exit(EXIT_SUCCESS);
             }
 
-            close(inPipe[i][0]);
-            close(outPipe[i][1]);
+            struct reference a = findShared(A[i], count);
+            struct reference b = findShared(B[i], count);
+            struct reference r = findShared(R[i], 2 * count);
+            snprintf(referenceArgument, sizeof(referenceArgument), "%d:%zu:%d:%zu:%d:%zu:%zu:%ld", a.fd, a.offset,
+                     b.fd, b.offset, r.fd, r.offset, count, options->budget);
 
-            if (execlp("./intmul", "./intmul", NULL) == -1)
+            if (execv("./intmul", childArgv) == -1)
             {
-                fprintf(stderr, "%s Unable to execlp\n", argv);
+                fprintf(stderr, "%s Unable to execv\n", argv);
                 exit(EXIT_FAILURE);
             }
             break;
 
         // parent tasks
         default:
-            close(inPipe[i][0]);
-            close(outPipe[i][1]);
-            int fd = inPipe[i][1];
-
-            switch (i)
-            {
-            case 0:
-                writeToPipe(fd, Ah, Bh, argv);
-                break;
-            case 1:
-                writeToPipe(fd, Ah, Bl, argv);
-                break;
-            case 2:
-                writeToPipe(fd, Al, Bh, argv);
-                break;
-            case 3:
-                writeToPipe(fd, Al, Bl, argv);
-                break;
-            default:
-                fprintf(stderr, "%s Unallowed default-case reached\n", argv);
-                exit(EXIT_FAILURE);
-                break;
-            }
-
             break;
         }
     }
 }
 
 /**
- * @brief Method to read values from pipe
+ * @brief waits for the children in the order in which they finish; as soon as one child fails (or gets killed by a
+ *        signal), the product cannot be completed, so the other children get terminated instead of waited for
  *
- * @param result the array where the results (from the reading process) get written into
+ * @param pid process id which is needed to identify process (gets set to -1 for every child which was waited for)
+ * @param children the number of children
  * @param argv simple hand over of program name argv[0] for error messages
  */
-static void readFromPipe(char *result[], char *argv)
+static void waitForChildren(pid_t pid[], int children, char *argv)
 {
-    int count = 0;
+    int running = children;
 
-    while (count < 4)
+    while (running > 0)
     {
-        result[count] = NULL;
-        size_t size = 0, read = 0;
-        FILE *out = fdopen(outPipe[count][0], "r");
-        if ((read = getline(&result[count], &size, out)) == -1)
+        int status;
+        pid_t finished = waitpid(-1, &status, 0);
+
+        if (finished == -1)
         {
-            fprintf(stderr, "%s Error while reading from pipe\n", argv);
+            if (errno == EINTR)
+                continue;
+
+            fprintf(stderr, "%s Error while waiting for child\n", argv);
             exit(EXIT_FAILURE);
         }
 
-        size = 0;
+        int i = 0;
+        while (i < children && pid[i] != finished)
+        {
+            i++;
+        }
 
-        childindex[count] = read;
-        result[count][read - 1] = '\0';
+        if (i == children)
+            continue;
 
-        if (fclose(out) == EOF)
+        pid[i] = -1;
+        running--;
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
         {
-            fprintf(stderr, "%s Error while closing file! %s\n", argv, strerror(errno));
+            for (int j = 0; j < children; j++)
+            {
+                if (pid[j] != -1)
+                    kill(pid[j], SIGTERM);
+            }
+
+            fprintf(stderr, "%s Error while child exited\n", argv);
             exit(EXIT_FAILURE);
         }
-        count++;
     }
 }
 
 /**
- * @brief waits for each child pid to wait for
+ * @brief multiplies a and b in-process with the number-theoretic transform on a pool of threads
  *
- * @param pid process id which is needed to identify process
+ * @param product the array where the product gets written into (2 * count limbs)
+ * @param a the first factor
+ * @param b the second factor
+ * @param count the number of limbs of a and b
+ * @param threads the number of threads
  * @param argv simple hand over of program name argv[0] for error messages
  */
-static void waitForChildren(pid_t pid[], char *argv)
+static void multiplyNtt(limb_t product[], const limb_t a[], const limb_t b[], size_t count, int threads, char *argv)
 {
-    for (int i = 0; i < 4; i++)
+    struct pool *pool = threads > 1 ? poolCreate(threads) : NULL;
+
+    if (threads > 1 && pool == NULL)
     {
-        int status;
+        fprintf(stderr, "%s Cannot create thread pool!\n", argv);
+        exit(EXIT_FAILURE);
+    }
 
-        if (waitpid(pid[i], &status, 0) == -1)
-        {
-            fprintf(stderr, "%s Error while waiting for child\n", argv);
-            exit(EXIT_FAILURE);
-        }
+    mulNtt(product, a, count, b, count, pool);
 
-        if (WEXITSTATUS(status) != EXIT_SUCCESS)
-        {
-            fprintf(stderr, "%s Error while child exited\n", argv);
-            exit(EXIT_FAILURE);
-        }
+    if (pool != NULL)
+    {
+        poolDestroy(pool);
     }
 }
 
 /**
- * @brief Method to merge calculation-results of childs
+ * @brief multiplies a and b in this process without children: the same divide-and-conquer, but with the sequential
+ *        thread engine (without a pool)
  *
- * @param result the array where the results are written into
- * @param resultsOfChildren the different results from all childs
- * @param length the length of the input
+ * @param product the array where the product gets written into (2 * count limbs)
+ * @param a the first factor
+ * @param b the second factor
+ * @param count the number of limbs of a and b
+ * @param options the options of the multiplication
+ */
+static void multiplyInline(limb_t product[], const limb_t a[], const limb_t b[], size_t count,
+                           struct options *options)
+{
+    struct mulSettings settings = {NULL, options->karatsuba, options->threshold / LIMB_DIGITS, 0, 0};
+
+    if (settings.threshold == 0)
+        settings.threshold = 1;
+
+    mulSplit(product, a, b, count, &settings);
+}
+
+/**
+ * @brief multiplies a and b: in-process with the schoolbook method if they are not longer than the threshold
+ *        (base-case), otherwise the halves get multiplied by children (4 products or 3 with karatsuba) and the
+ *        results of the children get merged; very large factors get multiplied in-process with the
+ *        number-theoretic transform instead. The budget limits how many processes may compute at once: the
+ *        children share the budget of their parent, and a budget which is too small for all children gets
+ *        multiplied inline instead of forked. The children read their factors in place from shared memory and write
+ *        their products directly into the product or into the shared scratch of this level
+ *
+ * @param product the array where the product gets written into (2 * count limbs)
+ * @param a the first factor
+ * @param b the second factor
+ * @param count the number of limbs of a and b
+ * @param context the options of the multiplication (struct options)
+ */
+static void multiplyWithChildren(limb_t product[], const limb_t a[], const limb_t b[], size_t count, void *context)
+{
+    struct options *options = context;
+    char *argv = options->argv;
+
+    if (options->nttThreshold > 0 && count * LIMB_DIGITS >= options->nttThreshold && nttFits(count, count))
+    {
+        multiplyNtt(product, a, b, count, options->threads, argv);
+        return;
+    }
+
+    // a single limb cannot be split any further
+    if (count * LIMB_DIGITS <= options->threshold || count == 1)
+    {
+        mulBasecase(product, a, count, b, count);
+        return;
+    }
+
+    bool square = a == b;
+    int children = options->karatsuba || square ? 3 : 4;
+
+    // the process count stays limited by the budget instead of failing to fork
+    if (options->budget < children)
+    {
+        multiplyInline(product, a, b, count, options);
+        return;
+    }
+
+    // an odd number of limbs cannot be split into equal halves, so the most significant limbs get added afterwards
+    if (count % 2 == 1)
+    {
+        multiplyWithChildren(product, a, b, count - 1, context);
+        addLastLimbs(product, a, b, count);
+        return;
+    }
+
+    // factors or a product outside of shared memory (e.g. the partial products of mulUnbalanced) get copied into
+    // a shared region once, so that the children of all levels below can work in place
+    if (findShared(a, count).fd == -1 || findShared(b, count).fd == -1 || findShared(product, 2 * count).fd == -1)
+    {
+        limb_t *staged = allocateShared(4 * count, argv);
+        memcpy(staged, a, count * sizeof(limb_t));
+        memcpy(staged + count, b, count * sizeof(limb_t));
+
+        // a square stays a square
+        multiplyWithChildren(staged + 2 * count, staged, a == b ? staged : staged + count, count, context);
+
+        memcpy(product, staged + 2 * count, 2 * count * sizeof(limb_t));
+        freeShared(staged, argv);
+        return;
+    }
+
+    size_t half = count / 2;
+    const limb_t *al = a, *ah = a + half;
+    const limb_t *bl = b, *bh = b + half;
+
+    // karatsuba: Al*Bl, Ah*Bh and (Ah+Al)*(Bh+Bl); otherwise: Al*Bl, Ah*Bh, Ah*Bl and Al*Bh (only Ah*Al once
+    // for a square); Al*Bl and Ah*Bh get written directly into the lower and upper half of the product
+    limb_t *scratch = allocateShared(2 * count + 1 + 2 * half, argv);
+    limb_t *middle = scratch;
+    limb_t *sumA = scratch + 2 * count + 1;
+    limb_t *sumB = sumA + half;
+    limb_t carryA = 0, carryB = 0;
+    const limb_t *childA[4] = {al, ah, ah, al};
+    const limb_t *childB[4] = {bl, bh, bl, bh};
+    limb_t *resultsOfChildren[4] = {product, product + count, middle, middle + count};
+
+    pid_t pid[4];
+
+    // every child gets at least one process of the budget, the rest gets shared as evenly as possible
+    long budgets[4];
+    for (int i = 0; i < children; i++)
+    {
+        budgets[i] = options->budget / children + (i < options->budget % children);
+    }
+
+    // Al*Bl and Ah*Bh do not need the sums, so their children already run while the sums get calculated
+    forkChildren(childA, childB, resultsOfChildren, half, 2, budgets, options, pid);
+
+    if (options->karatsuba)
+    {
+        carryA = limbsAdd(sumA, al, ah, half);
+        carryB = carryA;
+
+        // for a square the middle product is a square too: (Al+Ah)^2
+        if (square)
+            sumB = sumA;
+        else
+            carryB = limbsAdd(sumB, bl, bh, half);
+
+        childA[2] = sumA;
+        childB[2] = sumB;
+    }
+
+    forkChildren(childA + 2, childB + 2, resultsOfChildren + 2, half, children - 2, budgets + 2, options, pid + 2);
+
+    waitForChildren(pid, children, argv);
+
+    // the children are finished, so their budget of processes is free for the threads of the merge; the merge of
+    // the top level (and of other long enough levels) adds its blocks in parallel instead of rippling one carry
+    struct pool *pool = NULL;
+    if (options->budget > 1 && count >= 2 * CARRY_BLOCK)
+    {
+        pool = poolCreate(options->budget);
+    }
+
+    if (options->karatsuba)
+    {
+        mergeKaratsuba(product, middle, sumA, sumB, carryA, carryB, count, pool);
+    }
+    else if (square)
+    {
+        mergeSquare(product, middle, count, pool);
+    }
+    else
+    {
+        mergeProducts(product, middle, count, pool);
+    }
+
+    if (pool != NULL)
+    {
+        poolDestroy(pool);
+    }
+
+    freeShared(scratch, argv);
+}
+
+/**
+ * @brief multiplies two factors with the same number of limbs with the divide-and-conquer of the thread engine
+ *
+ * @param product the array where the product gets written into (2 * count limbs)
+ * @param a the first factor
+ * @param b the second factor
+ * @param count the number of limbs of a and b
+ * @param context the settings of the thread engine (struct mulSettings)
+ */
+static void multiplySplit(limb_t product[], const limb_t a[], const limb_t b[], size_t count, void *context)
+{
+    mulSplit(product, a, b, count, context);
+}
+
+/**
+ * @brief creates the settings of the thread engine (including its pool) from the options
+ *
+ * @param settings the settings which get created
+ * @param options the options of the multiplication
+ */
+static void createSettings(struct mulSettings *settings, struct options *options)
+{
+    settings->pool = options->threads > 1 ? poolCreate(options->threads) : NULL;
+    settings->karatsuba = options->karatsuba;
+    settings->threshold = options->threshold / LIMB_DIGITS > 0 ? options->threshold / LIMB_DIGITS : 1;
+    settings->parallelDepth =
+        settings->pool != NULL ? parallelDepthFor(settings->pool->workers, options->karatsuba ? 3 : 4) : 0;
+    settings->nttThreshold = LIMBS_FOR_DIGITS(options->nttThreshold);
+
+    if (options->threads > 1 && settings->pool == NULL)
+    {
+        fprintf(stderr, "%s Cannot create thread pool!\n", options->argv);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief multiplies a and b with the thread engine: the same divide-and-conquer as with the children, but in
+ *        shared memory and on a work-stealing pool of threads
+ *
+ * @param product the array where the product gets written into (aCount + bCount limbs)
+ * @param a the first factor
+ * @param aCount the number of limbs of a
+ * @param b the second factor
+ * @param bCount the number of limbs of b
+ * @param options the options of the multiplication
+ */
+static void multiplyThreaded(limb_t product[], const limb_t a[], size_t aCount, const limb_t b[], size_t bCount,
+                             struct options *options)
+{
+    struct mulSettings settings;
+    createSettings(&settings, options);
+
+    mulUnbalanced(product, a, aCount, b, bCount, settings.threshold, multiplySplit, &settings);
+
+    if (settings.pool != NULL)
+    {
+        poolDestroy(settings.pool);
+    }
+}
+
+/**
+ * @brief returns the current time in seconds (monotonic clock)
+ *
+ * @return double the current time
+ */
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/**
+ * @brief measures the time of an in-process multiplication of the given length (average of several runs)
+ *
+ * @param length the number of digits of both factors
  * @param argv simple hand over of program name argv[0] for error messages
+ * @return double the time of one multiplication in seconds
  */
-static void calculateResult(char result[], char *resultsOfChildren[], int length, char *argv)
+static double measureInProcess(int length, char *argv)
 {
-    int ahbh_index = childindex[0] - 2;
-    int ahbl_index = childindex[1] - 2;
-    int albh_index = childindex[2] - 2;
-    int albl_index = childindex[3] - 2;
+    // up to 2^20 digits, which would be too large for the stack
+    int limbs = LIMBS_FOR_DIGITS(length);
+    limb_t *a = allocateLimbs(4 * limbs, argv);
+    limb_t *b = a + limbs;
+    limb_t *product = b + limbs;
 
-    int carry = 0;
+    for (int i = 0; i < limbs; i++)
+    {
+        a[i] = b[i] = UINT64_MAX - i;
+    }
 
-    for (int i = length * 2 - 1; i >= 0; i--)
+    int runs = 0;
+    double start = now(), elapsed;
+    do
     {
-        if (i >= length + length / 2)
-        {
-            result[i] = albl_index >= 0 ? resultsOfChildren[3][albl_index--] : 0;
-        }
-        else if (i >= length) // ahbh0, ahbl1, albh2, albl3
+        mulBasecase(product, a, limbs, b, limbs);
+        runs++;
+    } while ((elapsed = now() - start) < 0.01);
+
+    free(a);
+
+    return elapsed / runs;
+}
+
+/**
+ * @brief measures the time which is needed to fork (and exec, if enabled) and wait for one child (average of
+ *        several runs)
+ *
+ * @param options the options of the multiplication
+ * @return double the time for one child in seconds
+ */
+static double measureSpawn(struct options *options)
+{
+    char *argv = options->argv;
+
+    // one limb for each factor and two limbs for the product
+    limb_t *limbs = allocateShared(4, argv);
+    limbs[0] = limbs[1] = 1;
+    const limb_t *A[1] = {limbs};
+    const limb_t *B[1] = {limbs + 1};
+    limb_t *results[1] = {limbs + 2};
+    const long budgets[1] = {1};
+    pid_t pid[1];
+
+    int runs = 20;
+    double start = now();
+    for (int i = 0; i < runs; i++)
+    {
+        forkChildren(A, B, results, 1, 1, budgets, options, pid);
+        waitForChildren(pid, 1, argv);
+    }
+    double elapsed = now() - start;
+
+    freeShared(limbs, argv);
+
+    return elapsed / runs;
+}
+
+/**
+ * @brief finds the best threshold on this host: a product gets calculated in-process as long as this is faster
+ *        than forking the children (which then calculate the halves in-process)
+ *
+ * @param options the options of the multiplication
+ * @return int the best threshold (number of digits)
+ */
+static int autotuneThreshold(struct options *options)
+{
+    int children = options->karatsuba ? 3 : 4;
+    double spawn = measureSpawn(options);
+    double half = measureInProcess(1, options->argv);
+
+    for (int length = 2; length <= (1 << 20); length *= 2)
+    {
+        double whole = measureInProcess(length, options->argv);
+
+        if (whole > children * (spawn + half))
+            return length / 2;
+
+        half = whole;
+    }
+
+    return 1 << 20;
+}
+
+/**
+ * @brief returns the second factor for the multiplication: a itself if both factors are equal, so that the square
+ *        gets calculated with the faster square paths (which check for the same array), otherwise b
+ *
+ * @param a the first factor
+ * @param aCount the number of limbs of a
+ * @param b the second factor
+ * @param bCount the number of limbs of b
+ * @return const limb_t* a if a and b are equal, otherwise b
+ */
+static const limb_t *secondFactor(const limb_t a[], size_t aCount, const limb_t b[], size_t bCount)
+{
+    if (aCount == bCount && memcmp(a, b, aCount * sizeof(limb_t)) == 0)
+        return a;
+
+    return b;
+}
+
+/**
+ * @brief checks if the input is valid and removes the newline at its end
+ *
+ * @param input the input which needs to be checked
+ * @param base the base of the input
+ * @param argv simple hand over of program name argv[0] for error messages
+ * @return size_t the number of digits of the input
+ */
+static size_t checkInput(char *input, int base, char *argv)
+{
+    size_t length = strlen(input);
+
+    // remove newline of input
+    if (length > 0 && input[length - 1] == '\n')
+    {
+        input[--length] = '\0';
+    }
+
+    if (radixValidate(input, length, base) != length)
+    {
+        fprintf(stderr, "%s Input has to be a valid integer of base %d!\n", argv, base);
+
+        exit(EXIT_FAILURE);
+    }
+
+    return length;
+}
+
+/**
+ * @brief returns the max number of chars of a formatted number (without '\0')
+ *
+ * @param count the number of limbs of the number
+ * @param digits the number of digits of the hexadecimal format
+ * @param options the options with the input and the output base
+ * @return size_t the max number of chars
+ */
+static size_t formattedLength(size_t count, size_t digits, struct options *options)
+{
+    size_t length = radixDigits(count, options->outputBase);
+
+    return digits > length ? digits : length;
+}
+
+/**
+ * @brief converts a number to the output base: if both bases are 16, the hexadecimal string has exactly the given
+ *        number of digits (the format without other bases), otherwise the string has no leading zeros
+ *
+ * @param result the array where the string gets written into (formattedLength(count, digits, options) + 1 chars)
+ * @param number the number
+ * @param count the number of limbs of the number
+ * @param digits the number of digits of the hexadecimal format
+ * @param settings the settings of the multiplications of the conversion
+ * @param options the options with the input and the output base
+ */
+static void formatNumber(char result[], const limb_t number[], size_t count, size_t digits,
+                         const struct mulSettings *settings, struct options *options)
+{
+    if (options->inputBase == 16 && options->outputBase == 16)
+        limbsToHex(result, number, count, digits);
+    else
+        limbsToRadix(result, number, count, options->outputBase, settings);
+}
+
+/**
+ * @brief one pair of the stream mode; the buffers are kept and only grow, so they get reused by later pairs
+ *
+ */
+struct pair
+{
+    char *first;
+    size_t firstSize;
+    size_t firstLength;
+    char *second;
+    size_t secondSize;
+    size_t secondLength;
+    limb_t *limbs;
+    size_t limbCapacity;
+    char *result;
+    size_t resultCapacity;
+    struct mulSettings *settings;
+    struct options *options;
+};
+
+/**
+ * @brief makes sure that the buffer has at least the given size
+ *
+ * @param buffer the buffer (may be NULL)
+ * @param capacity the current size of the buffer, gets updated
+ * @param size the needed size
+ * @param argv simple hand over of program name argv[0] for error messages
+ * @return void* the (possibly moved) buffer
+ */
+static void *reserve(void *buffer, size_t *capacity, size_t size, char *argv)
+{
+    if (size <= *capacity)
+        return buffer;
+
+    buffer = realloc(buffer, size);
+    if (buffer == NULL)
+    {
+        fprintf(stderr, "%s Cannot allocate memory!\n", argv);
+        exit(EXIT_FAILURE);
+    }
+    *capacity = size;
+
+    return buffer;
+}
+
+/**
+ * @brief multiplies the two (already checked) factors of the pair and formats the product (task of the pool)
+ *
+ * @param argument the pair (struct pair)
+ */
+static void multiplyPair(void *argument)
+{
+    struct pair *pair = argument;
+
+    size_t lenFirst = pair->firstLength;
+    size_t lenSecond = pair->secondLength;
+
+    // the product gets printed in the same format as without the stream mode
+    size_t neededLength = 1;
+    size_t max = lenFirst > lenSecond ? lenFirst : lenSecond;
+    while (neededLength < max)
+    {
+        neededLength *= 2;
+    }
+
+    struct options *options = pair->options;
+    size_t aCount = radixLimbs(lenFirst, options->inputBase);
+    size_t bCount = radixLimbs(lenSecond, options->inputBase);
+    size_t resultLength = formattedLength(aCount + bCount, 2 * neededLength, options);
+    pair->limbs = reserve(pair->limbs, &pair->limbCapacity, 2 * (aCount + bCount) * sizeof(limb_t), options->argv);
+    pair->result = reserve(pair->result, &pair->resultCapacity, resultLength + 1, options->argv);
+
+    limb_t *a = pair->limbs, *b = a + aCount, *product = b + bCount;
+
+    limbsFromRadix(a, pair->first, lenFirst, options->inputBase, pair->settings);
+    limbsFromRadix(b, pair->second, lenSecond, options->inputBase, pair->settings);
+
+    mulUnbalanced(product, a, aCount, secondFactor(a, aCount, b, bCount), bCount, pair->settings->threshold,
+                  multiplySplit, pair->settings);
+
+    formatNumber(pair->result, product, aCount + bCount, 2 * neededLength, pair->settings, options);
+}
+
+/**
+ * @brief the result of reading one factor of a stream
+ *
+ */
+enum factorStatus
+{
+    FACTOR_READ,
+    FACTOR_END,
+    FACTOR_EMPTY,
+    FACTOR_INVALID
+};
+
+/**
+ * @brief reads one line into the buffer, removes the newline and checks it without terminating the program, so
+ *        that the caller can finish its work before it reports an invalid line
+ *
+ * @param line the buffer of the line
+ * @param size the size of the buffer
+ * @param length the number of digits of the line
+ * @param input the stream where the line gets read from
+ * @param base the base of the line
+ * @return enum factorStatus FACTOR_READ for a valid factor, FACTOR_END at the end of the stream, FACTOR_EMPTY or
+ *         FACTOR_INVALID otherwise
+ */
+static enum factorStatus scanFactor(char **line, size_t *size, size_t *length, FILE *input, int base)
+{
+    if (getline(line, size, input) == -1)
+        return FACTOR_END;
+
+    *length = strlen(*line);
+
+    // remove newline of input
+    if (*length > 0 && (*line)[*length - 1] == '\n')
+    {
+        (*line)[--*length] = '\0';
+    }
+
+    if (*length == 0)
+        return FACTOR_EMPTY;
+
+    return radixValidate(*line, *length, base) == *length ? FACTOR_READ : FACTOR_INVALID;
+}
+
+/**
+ * @brief prints the error message of an empty or invalid factor and terminates the program
+ *
+ * @param status the status of the factor (FACTOR_EMPTY or FACTOR_INVALID)
+ * @param base the base of the factor
+ * @param argv simple hand over of program name argv[0] for error messages
+ */
+static void reportFactor(enum factorStatus status, int base, char *argv)
+{
+    if (status == FACTOR_EMPTY)
+        fprintf(stderr, "%s Input of integers of base %d must not be nothing!\n", argv, base);
+    else
+        fprintf(stderr, "%s Input has to be a valid integer of base %d!\n", argv, base);
+
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief reads one line into the buffer, checks it and removes the newline; terminates the program if the line is
+ *        empty or invalid
+ *
+ * @param line the buffer of the line
+ * @param size the size of the buffer
+ * @param length the number of digits of the line
+ * @param input the stream where the line gets read from
+ * @param base the base of the line
+ * @param argv simple hand over of program name argv[0] for error messages
+ * @return true if a line was read
+ * @return false at the end of the stream
+ */
+static bool readFactor(char **line, size_t *size, size_t *length, FILE *input, int base, char *argv)
+{
+    enum factorStatus status = scanFactor(line, size, length, input, base);
+
+    if (status == FACTOR_END)
+        return false;
+
+    if (status != FACTOR_READ)
+        reportFactor(status, base, argv);
+
+    return true;
+}
+
+/**
+ * @brief the stream mode: reads pairs of factors (two lines each) until the end of the input and prints one product
+ *        per line. Pairs get collected into batches which get multiplied in parallel on one pool of threads (the
+ *        pool and all buffers are reused); a batch gets finished early if no further input is ready yet, and the
+ *        products of a batch get printed in the order of the input
+ *
+ * @param input the stream of the pairs
+ * @param options the options of the multiplication
+ */
+static void streamProducts(FILE *input, struct options *options)
+{
+    char *argv = options->argv;
+    struct mulSettings settings;
+    createSettings(&settings, options);
+
+    int batchSize = 4 * options->threads;
+    struct pair *pairs = calloc(batchSize, sizeof(*pairs));
+    if (pairs == NULL)
+    {
+        fprintf(stderr, "%s Cannot allocate memory!\n", argv);
+        exit(EXIT_FAILURE);
+    }
+
+    // an invalid line gets reported after the products of the pairs before it got printed
+    enum factorStatus failure = FACTOR_END;
+    bool missing = false;
+
+    bool end = false;
+    while (!end)
+    {
+        int count = 0;
+
+        while (count < batchSize)
         {
-            int ahbl = ahbl_index >= 0 ? convertSingleHexToInt(resultsOfChildren[1][ahbl_index--], argv) : 0;
-            int albh = albh_index >= 0 ? convertSingleHexToInt(resultsOfChildren[2][albh_index--], argv) : 0;
-            int albl = albl_index >= 0 ? convertSingleHexToInt(resultsOfChildren[3][albl_index--], argv) : 0;
+            struct pair *pair = &pairs[count];
 
-            int partResult = ahbl + albh + albl + carry;
+            failure = scanFactor(&pair->first, &pair->firstSize, &pair->firstLength, input, options->inputBase);
+            if (failure != FACTOR_READ)
+            {
+                end = true;
+                break;
+            }
+            failure = scanFactor(&pair->second, &pair->secondSize, &pair->secondLength, input, options->inputBase);
+            if (failure != FACTOR_READ)
+            {
+                missing = failure == FACTOR_END;
+                end = true;
+                break;
+            }
+            pair->settings = &settings;
+            pair->options = options;
+            count++;
 
-            result[i] = convertIntToSingleHex(partResult, argv);
-            carry = partResult / 16;
+            // do not wait for more pairs if the writer of the input has nothing more yet
+            struct pollfd ready = {fileno(input), POLLIN, 0};
+            if (poll(&ready, 1, 0) == 0)
+                break;
+        }
+
+        if (settings.pool != NULL)
+        {
+            struct taskGroup group = {0};
+            for (int i = 1; i < count; i++)
+            {
+                poolSpawn(settings.pool, &group, multiplyPair, &pairs[i]);
+            }
+            if (count > 0)
+                multiplyPair(&pairs[0]);
+            poolWait(settings.pool, &group);
         }
         else
         {
-            int ahbh = ahbh_index >= 0 ? convertSingleHexToInt(resultsOfChildren[0][ahbh_index--], argv) : 0;
-            int ahbl = ahbl_index >= 0 ? convertSingleHexToInt(resultsOfChildren[1][ahbl_index--], argv) : 0;
-            int albh = albh_index >= 0 ? convertSingleHexToInt(resultsOfChildren[2][albh_index--], argv) : 0;
-            int albl = albl_index >= 0 ? convertSingleHexToInt(resultsOfChildren[3][albl_index--], argv) : 0;
-
-            int partResult = ahbh + ahbl + albh + albl + carry;
+            for (int i = 0; i < count; i++)
+            {
+                multiplyPair(&pairs[i]);
+            }
+        }
 
-            result[i] = convertIntToSingleHex(partResult, argv);
-            carry = partResult / 16;
+        for (int i = 0; i < count; i++)
+        {
+            fprintf(stdout, "%s\n", pairs[i].result);
         }
+        fflush(stdout);
     }
 
-    result[length * 2] = '\0';
+    for (int i = 0; i < batchSize; i++)
+    {
+        free(pairs[i].first);
+        free(pairs[i].second);
+        free(pairs[i].limbs);
+        free(pairs[i].result);
+    }
+    free(pairs);
 
-    for (int i = 0; i < 4; i++)
+    if (settings.pool != NULL)
     {
-        free(resultsOfChildren[i]);
+        poolDestroy(settings.pool);
     }
 
-    fprintf(stdout, "%s\n", result);
-    fflush(stdout);
+    if (missing)
+    {
+        fprintf(stderr, "%s The second factor of the last pair is missing\n", argv);
+        exit(EXIT_FAILURE);
+    }
+    if (failure != FACTOR_END)
+        reportFactor(failure, options->inputBase, argv);
 }
 
 /**
- * @brief checks if the input is valid
+ * @brief the power mode: reads triples of a base, an exponent and a modulus (three lines each) until the end of the
+ *        input and prints base^exponent mod modulus for every triple (in hexadecimal with as many digits as the
+ *        modulus). The
+ *        constants of the reduction get calculated only once as long as the modulus does not change, and all buffers
+ *        are reused
  *
- * @param input the input which needs to be checked
- * @param argv simple hand over of program name argv[0] for error messages
+ * @param input the stream of the triples
+ * @param options the options of the multiplication
  */
-static void checkInput(char *input, char *argv)
+static void modularPowers(FILE *input, struct options *options)
 {
-    for (int i = 0; i < strlen(input); i++)
+    char *argv = options->argv;
+    struct mulSettings settings;
+    createSettings(&settings, options);
+
+    // base, exponent and modulus
+    char *lines[3] = {NULL, NULL, NULL};
+    size_t sizes[3] = {0, 0, 0};
+    size_t lengths[3];
+    limb_t *numbers[3] = {NULL, NULL, NULL};
+    size_t capacities[3] = {0, 0, 0};
+    limb_t *power = NULL;
+    size_t powerCapacity = 0;
+    char *result = NULL;
+    size_t resultCapacity = 0;
+
+    struct barrett barrett;
+    bool reduction = false;
+
+    while (readFactor(&lines[0], &sizes[0], &lengths[0], input, options->inputBase, argv))
     {
-        // remove newspaces of input
-        if (input[i] == '\n')
+        size_t counts[3];
+
+        for (int i = 0; i < 3; i++)
         {
-            input[i] = '\0';
-            break;
+            if (i > 0 && !readFactor(&lines[i], &sizes[i], &lengths[i], input, options->inputBase, argv))
+            {
+                fprintf(stderr, "%s The exponent or the modulus of the last triple is missing\n", argv);
+                exit(EXIT_FAILURE);
+            }
+
+            counts[i] = radixLimbs(lengths[i], options->inputBase);
+            numbers[i] = reserve(numbers[i], &capacities[i], counts[i] * sizeof(limb_t), argv);
+            limbsFromRadix(numbers[i], lines[i], lengths[i], options->inputBase, &settings);
         }
 
-        if (!isdigit(input[i]) && !(input[i] >= 'A' && input[i] <= 'F') && !(input[i] >= 'a' && input[i] <= 'f'))
+        // the most significant limb of the modulus must not be 0
+        size_t modulusCount = counts[2];
+        while (modulusCount > 0 && numbers[2][modulusCount - 1] == 0)
         {
-            fprintf(stderr, "%s Input has to be a valid hexadecimal integer!\n", argv);
+            modulusCount--;
+        }
 
+        if (modulusCount == 0)
+        {
+            fprintf(stderr, "%s The modulus must not be zero\n", argv);
             exit(EXIT_FAILURE);
         }
+
+        if (!reduction || limbsCompare(numbers[2], modulusCount, barrett.modulus, barrett.count) != 0)
+        {
+            if (reduction)
+                barrettFree(&barrett);
+
+            barrettInit(&barrett, numbers[2], modulusCount, &settings);
+            reduction = true;
+        }
+
+        power = reserve(power, &powerCapacity, modulusCount * sizeof(limb_t), argv);
+        result = reserve(result, &resultCapacity, formattedLength(modulusCount, lengths[2], options) + 1, argv);
+
+        modPow(power, numbers[0], counts[0], numbers[1], counts[1], &barrett);
+
+        formatNumber(result, power, modulusCount, lengths[2], &settings, options);
+        fprintf(stdout, "%s\n", result);
+    }
+    fflush(stdout);
+
+    if (reduction)
+        barrettFree(&barrett);
+
+    for (int i = 0; i < 3; i++)
+    {
+        free(lines[i]);
+        free(numbers[i]);
+    }
+    free(power);
+    free(result);
+
+    if (settings.pool != NULL)
+    {
+        poolDestroy(settings.pool);
     }
 }
 
@@ -427,99 +1219,265 @@ static void checkInput(char *input, char *argv)
  */
 int main(int argc, char *argv[])
 {
-    if (argc > 1)
+    bool karatsuba = false;
+    bool autotune = false;
+    bool threaded = false;
+    // the children of the process engine exec ./intmul unless "-m fork" is given
+    bool exec = true;
+    char *references = NULL;
+    bool stream = false;
+    bool powers = false;
+    char *file = NULL;
+    int inputBase = 16;
+    int outputBase = 16;
+    long threshold = DEFAULT_THRESHOLD;
+    long nttThreshold = DEFAULT_NTT_THRESHOLD;
+    // the thread engine uses one thread per core by default, and the process engine lets as many children compute
+    // at once
+    long threads = sysconf(_SC_NPROCESSORS_ONLN) > 0 ? sysconf(_SC_NPROCESSORS_ONLN) : 1;
+
+    int c;
+    char *endChar;
+    while ((c = getopt(argc, argv, "kt:am:j:n:spf:i:o:r:")) != -1)
     {
-        fprintf(stderr, "SYNOPSIS:\n%s\n", argv[0]);
-        exit(EXIT_FAILURE);
+        switch (c)
+        {
+        case 'k':
+            karatsuba = true;
+            break;
+        case 't':
+            threshold = strtol(optarg, &endChar, 10);
+            if (*endChar != '\0' || threshold < 1)
+            {
+                usage(argv[0]);
+            }
+            break;
+        case 'a':
+            autotune = true;
+            break;
+        case 'm':
+            if (strcmp(optarg, "thread") != 0 && strcmp(optarg, "process") != 0 && strcmp(optarg, "fork") != 0)
+            {
+                usage(argv[0]);
+            }
+            threaded = strcmp(optarg, "thread") == 0;
+            exec = strcmp(optarg, "process") == 0;
+            break;
+        case 'j':
+            threads = strtol(optarg, &endChar, 10);
+            if (*endChar != '\0' || threads < 1 || threads > 1024)
+            {
+                usage(argv[0]);
+            }
+            break;
+        case 'n':
+            nttThreshold = strtol(optarg, &endChar, 10);
+            if (*endChar != '\0' || nttThreshold < 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+        case 's':
+            stream = true;
+            break;
+        case 'p':
+            powers = true;
+            break;
+        case 'f':
+            file = optarg;
+            break;
+        case 'i':
+        case 'o':
+        {
+            long base = strtol(optarg, &endChar, 10);
+            if (*endChar != '\0' || base < MIN_BASE || base > MAX_BASE)
+            {
+                usage(argv[0]);
+            }
+            if (c == 'i')
+                inputBase = base;
+            else
+                outputBase = base;
+            break;
+        }
+        // only used for the children: the positions of the factors and the product in shared memory
+        case 'r':
+            references = optarg;
+            break;
+        default:
+            usage(argv[0]);
+        }
     }
 
-    char *line = NULL;
-    size_t size = 0;
-
-    char *firstHexInt;
-    char *secondHexInt;
+    if (argc - optind > 0 || (file != NULL && !stream && !powers) || (stream && powers))
+    {
+        usage(argv[0]);
+    }
 
-    int count = 0;
+    // children get called with the same options
+    int childArgc = 0;
+    childArgv[childArgc++] = "./intmul";
+    if (karatsuba)
+    {
+        childArgv[childArgc++] = "-k";
+    }
+    snprintf(thresholdArgument, sizeof(thresholdArgument), "%ld", threshold);
+    childArgv[childArgc++] = "-t";
+    childArgv[childArgc++] = thresholdArgument;
+    snprintf(nttThresholdArgument, sizeof(nttThresholdArgument), "%ld", nttThreshold);
+    childArgv[childArgc++] = "-n";
+    childArgv[childArgc++] = nttThresholdArgument;
+    childArgv[childArgc++] = "-r";
+    childArgv[childArgc++] = referenceArgument;
+    childArgv[childArgc] = NULL;
+
+    struct options options = {karatsuba, threshold, nttThreshold, threads, exec, threads, argv[0], inputBase,
+                              outputBase};
+
+    // only find the best threshold for this host and print it
+    if (autotune)
+    {
+        fprintf(stdout, "%d\n", autotuneThreshold(&options));
+        exit(EXIT_SUCCESS);
+    }
 
-    // read line from stdin
-    while (getline(&line, &size, stdin) != -1)
+    // a child gets the positions of both factors and of its product in the shared memory of its parent
+    if (references != NULL)
     {
-        if (count == 0)
+        struct reference refA, refB, refProduct;
+        size_t count;
+
+        if (sscanf(references, "%d:%zu:%d:%zu:%d:%zu:%zu:%ld", &refA.fd, &refA.offset, &refB.fd, &refB.offset,
+                   &refProduct.fd, &refProduct.offset, &count, &options.budget) != 8 ||
+            count == 0 || options.budget < 1)
         {
-            firstHexInt = strdup(line);
-            count++;
+            usage(argv[0]);
         }
 
-        else if (count == 1)
+        const limb_t *a = openShared(refA, count, argv[0]);
+        const limb_t *b = openShared(refB, count, argv[0]);
+        limb_t *product = openShared(refProduct, 2 * count, argv[0]);
+
+        multiplyWithChildren(product, a, b, count, &options);
+
+        exit(EXIT_SUCCESS);
+    }
+
+    // the stream and the power mode always use the thread engine, so that the threads get reused for all inputs
+    if (stream || powers)
+    {
+        FILE *input = file != NULL ? fopen(file, "r") : stdin;
+        if (input == NULL)
         {
-            secondHexInt = strdup(line);
-            count++;
-            break;
+            fprintf(stderr, "%s Cannot open %s! %s\n", argv[0], file, strerror(errno));
+            exit(EXIT_FAILURE);
         }
+
+        if (powers)
+            modularPowers(input, &options);
+        else
+            streamProducts(input, &options);
+
+        if (input != stdin)
+            fclose(input);
+        exit(EXIT_SUCCESS);
     }
 
-    if (count != 2)
+    // read both lines from stdin directly into their own buffers (without copying them)
+    char *firstHexInt = NULL;
+    char *secondHexInt = NULL;
+    size_t firstSize = 0, secondSize = 0;
+
+    if (getline(&firstHexInt, &firstSize, stdin) == -1 || getline(&secondHexInt, &secondSize, stdin) == -1)
     {
-        fprintf(stderr, "SYNOPSIS:\n%s\n", argv[0]);
-        exit(EXIT_FAILURE);
+        usage(argv[0]);
     }
 
     // check if input is valid
-    checkInput(firstHexInt, argv[0]);
-    checkInput(secondHexInt, argv[0]);
-
-    free(line);
-
-    int lenFirst = strlen(firstHexInt);
-    int lenSecond = strlen(secondHexInt);
+    size_t lenFirst = checkInput(firstHexInt, inputBase, argv[0]);
+    size_t lenSecond = checkInput(secondHexInt, inputBase, argv[0]);
 
     if (lenFirst < 1 || lenSecond < 1)
     {
-        fprintf(stderr, "%s Input of hexadecimal integers must not be nothing\n", argv[0]);
+        fprintf(stderr, "%s Input of integers of base %d must not be nothing!\n", argv[0], inputBase);
         exit(EXIT_FAILURE);
     }
 
-    int neededLength = 1;
-    int max = lenFirst > lenSecond ? lenFirst : lenSecond;
+    // the product always has twice as many digits as the longer factor filled up to a power of two
+    size_t neededLength = 1;
+    size_t max = lenFirst > lenSecond ? lenFirst : lenSecond;
     while (neededLength < max)
     {
         neededLength *= 2;
     }
 
-    char correctFirstInt[neededLength + 1];
-    char correctSecondInt[neededLength + 1];
+    // convert the input to limbs once; the factors do not get filled up, only the printed product does
+    // (with children, factors and product are in shared memory, so that the children can use them in place)
+    size_t aCount = radixLimbs(lenFirst, inputBase);
+    size_t bCount = radixLimbs(lenSecond, inputBase);
+    limb_t *limbs = threaded ? allocateLimbs(2 * (aCount + bCount), argv[0])
+                             : allocateShared(2 * (aCount + bCount), argv[0]);
+    limb_t *a = limbs, *b = a + aCount, *product = b + bCount;
+    char *result = malloc(formattedLength(aCount + bCount, 2 * neededLength, &options) + 1);
+
+    if (result == NULL)
+    {
+        fprintf(stderr, "%s Cannot allocate memory!\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
 
-    // make input a 'valid' input by filling it up with missing zeros
-    inputCorrection(correctFirstInt, correctSecondInt, firstHexInt, secondHexInt, neededLength);
+    // other bases than 16 get converted with the thread engine, its pool is destroyed before any child gets forked
+    struct mulSettings settings = {0};
+    if (inputBase != 16)
+        createSettings(&settings, &options);
 
-    free(firstHexInt);
-    free(secondHexInt);
+    limbsFromRadix(a, firstHexInt, lenFirst, inputBase, &settings);
+    limbsFromRadix(b, secondHexInt, lenSecond, inputBase, &settings);
 
-    // multiply A and B if both consists of only 1 hexadecimal digit --> base-case
-    if (neededLength == 1)
+    if (settings.pool != NULL)
     {
-        int first = convertHexToInt(correctFirstInt, argv[0]);
-        int second = convertHexToInt(correctSecondInt, argv[0]);
+        poolDestroy(settings.pool);
+    }
 
-        int result = first * second;
+    free(firstHexInt);
+    free(secondHexInt);
 
-        fprintf(stdout, "%02x\n", result);
-        fflush(stdout);
-        exit(EXIT_SUCCESS);
-    }
-    pid_t pid[4];
+    const limb_t *second = secondFactor(a, aCount, b, bCount);
 
-    forkAndPipe(correctFirstInt, correctSecondInt, neededLength, argv[0], pid);
+    // factors with different lengths get multiplied in chunks with the length of the shorter one
+    if (threaded)
+    {
+        multiplyThreaded(product, a, aCount, second, bCount, &options);
+    }
+    else
+    {
+        mulUnbalanced(product, a, aCount, second, bCount, threshold / LIMB_DIGITS, multiplyWithChildren, &options);
+    }
 
-    waitForChildren(pid, argv[0]);
+    // convert the product to the output base once
+    settings.pool = NULL;
+    if (outputBase != 16)
+        createSettings(&settings, &options);
 
-    char *resultsOfChildren[4];
+    formatNumber(result, product, aCount + bCount, 2 * neededLength, &settings, &options);
 
-    char result[neededLength * 2 + 1];
+    if (settings.pool != NULL)
+    {
+        poolDestroy(settings.pool);
+    }
 
-    readFromPipe(resultsOfChildren, argv[0]);
+    fprintf(stdout, "%s\n", result);
+    fflush(stdout);
 
-    calculateResult(result, resultsOfChildren, neededLength, argv[0]);
+    if (threaded)
+    {
+        free(limbs);
+    }
+    else
+    {
+        freeShared(limbs, argv[0]);
+    }
+    free(result);
 
     return 0;
-}
\ No newline at end of file
+}
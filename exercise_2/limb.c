@@ -0,0 +1,1072 @@
+/**
+ * @file limb.c
+ * @author Florian Fürst (12122096)
+ * @brief in-process arithmetic on 64-bit limbs: schoolbook multiplication and the divide-and-conquer
+ *        multiplication of the thread engine
+ * @date 2022-12-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "limb.h"
+#include "ntt.h"
+
+/**
+ * @brief squares a with the schoolbook method: every cross product a[i]*a[j] (i < j) gets calculated only once and
+ *        doubled, then the squares a[i]^2 get added
+ *
+ * @param result the array where the square gets written into (2 * count limbs; must not overlap a)
+ * @param a the factor
+ * @param count the number of limbs of a
+ */
+void sqrBasecase(limb_t result[], const limb_t a[], size_t count)
+{
+    for (size_t i = 0; i < 2 * count; i++)
+    {
+        result[i] = 0;
+    }
+
+    for (size_t i = 0; i + 1 < count; i++)
+    {
+        result[i + count] = addMul1(result + 2 * i + 1, a + i + 1, count - i - 1, a[i]);
+    }
+
+    // the sum of the cross products is less than a^2 / 2, so doubling it does not overflow
+    limb_t high = 0;
+    for (size_t i = 0; i < 2 * count; i++)
+    {
+        limb_t next = result[i] >> 63;
+        result[i] = result[i] << 1 | high;
+        high = next;
+    }
+
+    limb_t carry = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        dlimb_t square = (dlimb_t)a[i] * a[i];
+        dlimb_t low = (dlimb_t)result[2 * i] + (limb_t)square + carry;
+        dlimb_t upper = (dlimb_t)result[2 * i + 1] + (limb_t)(square >> 64) + (limb_t)(low >> 64);
+
+        result[2 * i] = (limb_t)low;
+        result[2 * i + 1] = (limb_t)upper;
+        carry = (limb_t)(upper >> 64);
+    }
+}
+
+/**
+ * @brief multiplies a and b with the schoolbook method; if a and b are the same array, sqrBasecase gets used
+ *
+ * @param result the array where the product gets written into (aCount + bCount limbs; must not overlap a or b)
+ * @param a the first factor
+ * @param aCount the number of limbs of a
+ * @param b the second factor
+ * @param bCount the number of limbs of b
+ */
+void mulBasecase(limb_t result[], const limb_t a[], size_t aCount, const limb_t b[], size_t bCount)
+{
+    if (a == b && aCount == bCount)
+    {
+        sqrBasecase(result, a, aCount);
+        return;
+    }
+
+    for (size_t i = 0; i < aCount + bCount; i++)
+    {
+        result[i] = 0;
+    }
+
+    for (size_t i = 0; i < aCount; i++)
+    {
+        limb_t carry = 0;
+
+        for (size_t j = 0; j < bCount; j++)
+        {
+            dlimb_t partResult = (dlimb_t)a[i] * b[j] + result[i + j] + carry;
+
+            result[i + j] = (limb_t)partResult;
+            carry = (limb_t)(partResult >> 64);
+        }
+        result[i + bCount] = carry;
+    }
+}
+
+/**
+ * @brief adds a and b (both with the same number of limbs); r may be the same array as a or b
+ *
+ * @param r the array where the sum gets written into (count limbs, without the carry)
+ * @param a the first summand
+ * @param b the second summand
+ * @param count the number of limbs
+ * @return limb_t the carry of the sum (0 or 1)
+ */
+limb_t limbsAdd(limb_t r[], const limb_t a[], const limb_t b[], size_t count)
+{
+    limb_t carry = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dlimb_t partResult = (dlimb_t)a[i] + b[i] + carry;
+
+        r[i] = (limb_t)partResult;
+        carry = (limb_t)(partResult >> 64);
+    }
+
+    return carry;
+}
+
+/**
+ * @brief adds a to r (aCount <= rCount); the carry gets propagated through all limbs of r
+ *
+ * @param r the number where a gets added to
+ * @param rCount the number of limbs of r
+ * @param a the summand
+ * @param aCount the number of limbs of a
+ * @return limb_t the carry out of the most significant limb of r (0 or 1)
+ */
+limb_t limbsAddTo(limb_t r[], size_t rCount, const limb_t a[], size_t aCount)
+{
+    limb_t carry = limbsAdd(r, r, a, aCount);
+
+    for (size_t i = aCount; carry && i < rCount; i++)
+    {
+        carry = ++r[i] == 0;
+    }
+
+    return carry;
+}
+
+/**
+ * @brief subtracts a from r (aCount <= rCount); the borrow gets propagated through all limbs of r
+ *
+ * @param r the number where a gets subtracted from
+ * @param rCount the number of limbs of r
+ * @param a the subtrahend
+ * @param aCount the number of limbs of a
+ * @return limb_t the borrow out of the most significant limb of r (0 or 1)
+ */
+limb_t limbsSubFrom(limb_t r[], size_t rCount, const limb_t a[], size_t aCount)
+{
+    limb_t borrow = 0;
+
+    for (size_t i = 0; i < aCount; i++)
+    {
+        limb_t difference = r[i] - a[i] - borrow;
+
+        borrow = (r[i] < a[i]) || (r[i] - a[i] < borrow);
+        r[i] = difference;
+    }
+
+    for (size_t i = aCount; borrow && i < rCount; i++)
+    {
+        borrow = r[i]-- == 0;
+    }
+
+    return borrow;
+}
+
+/**
+ * @brief the state of a parallel addition or subtraction: every block gets added (or subtracted) on its own, which
+ *        gives its carry (or borrow) out and if it would pass an incoming carry on (all limbs of the sum are ones,
+ *        or all limbs of the difference are zeros)
+ *
+ */
+struct carryContext
+{
+    limb_t *r;
+    const limb_t *a;
+    size_t count;
+    bool subtract;
+    limb_t *carries;
+    limb_t *propagates;
+};
+
+/**
+ * @brief adds (or subtracts) the blocks [begin, end) without an incoming carry (task of poolParallelFor)
+ *
+ * @param begin the first block
+ * @param end the block after the last one
+ * @param argument the state of the addition (struct carryContext)
+ */
+static void carryBlocks(size_t begin, size_t end, void *argument)
+{
+    struct carryContext *context = argument;
+
+    for (size_t block = begin; block < end; block++)
+    {
+        size_t first = block * CARRY_BLOCK;
+        size_t count = context->count - first < CARRY_BLOCK ? context->count - first : CARRY_BLOCK;
+        limb_t *r = context->r + first;
+        limb_t passing = context->subtract ? 0 : ~(limb_t)0;
+        limb_t equal = ~(limb_t)0;
+
+        if (context->subtract)
+            context->carries[block] = limbsSubFrom(r, count, context->a + first, count);
+        else
+            context->carries[block] = limbsAdd(r, r, context->a + first, count);
+
+        // branch-free, so that the compiler can vectorize the check of the whole block
+        for (size_t i = 0; i < count; i++)
+        {
+            equal &= ~(r[i] ^ passing);
+        }
+        context->propagates[block] = equal == ~(limb_t)0;
+    }
+}
+
+/**
+ * @brief adds (or subtracts) the incoming carries of the blocks [begin, end) (task of poolParallelFor); the carry
+ *        stops inside the block unless the block passes it on, which the prefix pass has already taken into account
+ *
+ * @param begin the first block
+ * @param end the block after the last one
+ * @param argument the state of the addition (struct carryContext) with the incoming carry of every block
+ */
+static void carryIntoBlocks(size_t begin, size_t end, void *argument)
+{
+    struct carryContext *context = argument;
+    const limb_t one = 1;
+
+    for (size_t block = begin; block < end; block++)
+    {
+        if (!context->carries[block])
+            continue;
+
+        size_t first = block * CARRY_BLOCK;
+        size_t count = context->count - first < CARRY_BLOCK ? context->count - first : CARRY_BLOCK;
+
+        if (context->subtract)
+            limbsSubFrom(context->r + first, count, &one, 1);
+        else
+            limbsAddTo(context->r + first, count, &one, 1);
+    }
+}
+
+/**
+ * @brief adds a to r (or subtracts a from r) with carry-lookahead over blocks: all blocks get added in parallel, a
+ *        prefix pass over the carries of the blocks calculates the incoming carry of every block, and the incoming
+ *        carries get added in parallel again. Without a pool or for short numbers the carry simply ripples through
+ *
+ * @param r the number where a gets added to (or subtracted from)
+ * @param rCount the number of limbs of r
+ * @param a the summand (or subtrahend)
+ * @param aCount the number of limbs of a (aCount <= rCount)
+ * @param subtract true to subtract a from r
+ * @param pool the pool (may be NULL)
+ * @return limb_t the carry (or borrow) out of the most significant limb of r (0 or 1)
+ */
+static limb_t carryParallel(limb_t r[], size_t rCount, const limb_t a[], size_t aCount, bool subtract,
+                            struct pool *pool)
+{
+    size_t blocks = (aCount + CARRY_BLOCK - 1) / CARRY_BLOCK;
+
+    if (pool == NULL || blocks < 2)
+        return subtract ? limbsSubFrom(r, rCount, a, aCount) : limbsAddTo(r, rCount, a, aCount);
+
+    limb_t *carries = malloc(2 * blocks * sizeof(limb_t));
+    if (carries == NULL)
+        return subtract ? limbsSubFrom(r, rCount, a, aCount) : limbsAddTo(r, rCount, a, aCount);
+
+    struct carryContext context = {r, a, aCount, subtract, carries, carries + blocks};
+    poolParallelFor(pool, blocks, 1, carryBlocks, &context);
+
+    // the carry into a block is its own carry or the passed on carry of the block below
+    limb_t carry = 0;
+    for (size_t block = 0; block < blocks; block++)
+    {
+        limb_t out = carries[block] | (context.propagates[block] & carry);
+        carries[block] = carry;
+        carry = out;
+    }
+
+    poolParallelFor(pool, blocks, 1, carryIntoBlocks, &context);
+    free(carries);
+
+    for (size_t i = aCount; carry && i < rCount; i++)
+    {
+        carry = subtract ? r[i]-- == 0 : ++r[i] == 0;
+    }
+
+    return carry;
+}
+
+/**
+ * @brief adds a to r like limbsAddTo, the blocks get added in parallel on the pool
+ *
+ * @param r the number where a gets added to
+ * @param rCount the number of limbs of r
+ * @param a the summand
+ * @param aCount the number of limbs of a (aCount <= rCount)
+ * @param pool the pool (may be NULL)
+ * @return limb_t the carry out of the most significant limb of r (0 or 1)
+ */
+limb_t limbsAddToParallel(limb_t r[], size_t rCount, const limb_t a[], size_t aCount, struct pool *pool)
+{
+    return carryParallel(r, rCount, a, aCount, false, pool);
+}
+
+/**
+ * @brief subtracts a from r like limbsSubFrom, the blocks get subtracted in parallel on the pool
+ *
+ * @param r the number where a gets subtracted from
+ * @param rCount the number of limbs of r
+ * @param a the subtrahend
+ * @param aCount the number of limbs of a (aCount <= rCount)
+ * @param pool the pool (may be NULL)
+ * @return limb_t the borrow out of the most significant limb of r (0 or 1)
+ */
+limb_t limbsSubFromParallel(limb_t r[], size_t rCount, const limb_t a[], size_t aCount, struct pool *pool)
+{
+    return carryParallel(r, rCount, a, aCount, true, pool);
+}
+
+/**
+ * @brief adds a * factor to r (count limbs)
+ *
+ * @param r the number where the product gets added to (count limbs)
+ * @param a the first factor
+ * @param count the number of limbs of a
+ * @param factor the second factor (one limb)
+ * @return limb_t the carry out of the most significant limb of r
+ */
+limb_t addMul1(limb_t r[], const limb_t a[], size_t count, limb_t factor)
+{
+    limb_t carry = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dlimb_t partResult = (dlimb_t)a[i] * factor + r[i] + carry;
+
+        r[i] = (limb_t)partResult;
+        carry = (limb_t)(partResult >> 64);
+    }
+
+    return carry;
+}
+
+/**
+ * @brief completes the product of a and b (both with an odd number of limbs) if result already contains the product
+ *        of the lower count - 1 limbs: a*b = a'*b' + (a'*y + b*x) * B^(count - 1) with a = a' + x * B^(count - 1) and
+ *        b = b' + y * B^(count - 1)
+ *
+ * @param result the product (2 * count limbs) which contains a'*b' in the lower 2 * (count - 1) limbs
+ * @param a the first factor
+ * @param b the second factor
+ * @param count the number of limbs of a and b
+ */
+void addLastLimbs(limb_t result[], const limb_t a[], const limb_t b[], size_t count)
+{
+    size_t lower = count - 1;
+
+    result[2 * lower] = addMul1(result + lower, a, lower, b[lower]);
+    result[2 * count - 1] = addMul1(result + lower, b, count, a[lower]);
+}
+
+/**
+ * @brief merges the four products of the halves: result already contains Al*Bl and Ah*Bh (Ah*Bh * B^count + Al*Bl),
+ *        the middle products Ah*Bl and Al*Bh get added at half of the length
+ *
+ * @param result the product (2 * count limbs) which contains Al*Bl in the lower and Ah*Bh in the upper half
+ * @param middle Ah*Bl and Al*Bh (count limbs each)
+ * @param count the number of limbs of the factors
+ * @param pool the pool for the additions (may be NULL)
+ */
+void mergeProducts(limb_t result[], const limb_t middle[], size_t count, struct pool *pool)
+{
+    size_t half = count / 2;
+
+    limbsAddToParallel(result + half, 2 * count - half, middle, count, pool);
+    limbsAddToParallel(result + half, 2 * count - half, middle + count, count, pool);
+}
+
+/**
+ * @brief merges the products of the halves of a square: result already contains Al^2 and Ah^2
+ *        (Ah^2 * B^count + Al^2), the cross product Ah*Al gets added twice at half of the length
+ *
+ * @param result the square (2 * count limbs) which contains Al^2 in the lower and Ah^2 in the upper half
+ * @param middle Ah*Al (count limbs)
+ * @param count the number of limbs of the factor
+ * @param pool the pool for the additions (may be NULL)
+ */
+void mergeSquare(limb_t result[], const limb_t middle[], size_t count, struct pool *pool)
+{
+    size_t half = count / 2;
+
+    limbsAddToParallel(result + half, 2 * count - half, middle, count, pool);
+    limbsAddToParallel(result + half, 2 * count - half, middle, count, pool);
+}
+
+/**
+ * @brief merges the three products of karatsuba: result already contains Al*Bl and Ah*Bh (Ah*Bh * B^count + Al*Bl);
+ *        the sums of the halves are multiplied without their carry, so the missing parts get added here:
+ *        (sA + cA*B^h)(sB + cB*B^h) = sA*sB + (cA*sB + cB*sA)*B^h + cA*cB*B^2h
+ *
+ * @param result the product (2 * count limbs) which contains Al*Bl in the lower and Ah*Bh in the upper half
+ * @param middle sA*sB (count limbs); the array needs count + 1 limbs because it gets modified in place
+ * @param sumA the sum of the halves of A (without carry)
+ * @param sumB the sum of the halves of B (without carry)
+ * @param carryA the carry of the sum of the halves of A
+ * @param carryB the carry of the sum of the halves of B
+ * @param count the number of limbs of the factors
+ * @param pool the pool for the additions and subtractions (may be NULL)
+ */
+void mergeKaratsuba(limb_t result[], limb_t middle[], const limb_t sumA[], const limb_t sumB[],
+                    limb_t carryA, limb_t carryB, size_t count, struct pool *pool)
+{
+    size_t half = count / 2;
+
+    // middle = (sA + cA*B^h)(sB + cB*B^h) - Ah*Bh - Al*Bl; intermediate values may wrap around, the final
+    // value is exact because it fits into count + 1 limbs
+    middle[count] = 0;
+    limbsSubFromParallel(middle, count + 1, result, count, pool);
+    limbsSubFromParallel(middle, count + 1, result + count, count, pool);
+    if (carryA)
+        limbsAddToParallel(middle + half, count + 1 - half, sumB, half, pool);
+    if (carryB)
+        limbsAddToParallel(middle + half, count + 1 - half, sumA, half, pool);
+    if (carryA && carryB)
+        middle[count]++;
+
+    limbsAddToParallel(result + half, 2 * count - half, middle, count + 1, pool);
+}
+
+/**
+ * @brief allocates an array of limbs and terminates the program if there is not enough memory
+ *
+ * @param count the number of limbs (may be 0)
+ * @return limb_t* the array
+ */
+limb_t *limbsAllocate(size_t count)
+{
+    limb_t *limbs = malloc((count > 0 ? count : 1) * sizeof(limb_t));
+
+    if (limbs == NULL)
+    {
+        fprintf(stderr, "Cannot allocate memory for %zu limbs!\n", count);
+        exit(EXIT_FAILURE);
+    }
+
+    return limbs;
+}
+
+/**
+ * @brief compares a and b (the numbers may have different numbers of limbs)
+ *
+ * @param a the first number
+ * @param aCount the number of limbs of a
+ * @param b the second number
+ * @param bCount the number of limbs of b
+ * @return int a negative value if a < b, 0 if a == b and a positive value if a > b
+ */
+int limbsCompare(const limb_t a[], size_t aCount, const limb_t b[], size_t bCount)
+{
+    for (; aCount > bCount; aCount--)
+    {
+        if (a[aCount - 1] != 0)
+            return 1;
+    }
+    for (; bCount > aCount; bCount--)
+    {
+        if (b[bCount - 1] != 0)
+            return -1;
+    }
+
+    for (size_t i = aCount; i-- > 0;)
+    {
+        if (a[i] != b[i])
+            return a[i] > b[i] ? 1 : -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief shifts a to the left by less than one limb
+ *
+ * @param r the array where the shifted number gets written into (count limbs)
+ * @param a the number
+ * @param count the number of limbs of a
+ * @param shift the number of bits (0 to 63)
+ * @return limb_t the bits which got shifted out of the most significant limb
+ */
+static limb_t shiftLeft(limb_t r[], const limb_t a[], size_t count, int shift)
+{
+    limb_t high = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        limb_t limb = a[i];
+
+        r[i] = limb << shift | high;
+        high = shift > 0 ? limb >> (64 - shift) : 0;
+    }
+
+    return high;
+}
+
+/**
+ * @brief divides u by v with the schoolbook method (knuth's algorithm D): both numbers get shifted until the most
+ *        significant bit of v is set, so that every quotient limb can be estimated from the two leading limbs
+ *
+ * @param quotient the array where the quotient gets written into (uCount - vCount + 1 limbs)
+ * @param remainder the array where the remainder gets written into (vCount limbs)
+ * @param u the dividend (uCount >= vCount)
+ * @param uCount the number of limbs of u
+ * @param v the divisor (the most significant limb must not be 0)
+ * @param vCount the number of limbs of v
+ */
+void limbsDivRem(limb_t quotient[], limb_t remainder[], const limb_t u[], size_t uCount, const limb_t v[],
+                 size_t vCount)
+{
+    int shift = __builtin_clzll(v[vCount - 1]);
+    limb_t *vn = limbsAllocate(vCount);
+    limb_t *un = limbsAllocate(uCount + 1);
+
+    shiftLeft(vn, v, vCount, shift);
+    un[uCount] = shiftLeft(un, u, uCount, shift);
+
+    limb_t top = vn[vCount - 1];
+
+    for (size_t j = uCount - vCount + 1; j-- > 0;)
+    {
+        // the estimate from the two leading limbs is at most 2 too large
+        dlimb_t numerator = (dlimb_t)un[j + vCount] << 64 | un[j + vCount - 1];
+        dlimb_t qhat = numerator / top;
+        dlimb_t rhat = numerator % top;
+
+        while (qhat >> 64 || (vCount > 1 && qhat * vn[vCount - 2] > (rhat << 64 | un[j + vCount - 2])))
+        {
+            qhat--;
+            rhat += top;
+            if (rhat >> 64)
+                break;
+        }
+
+        // un[j..j + vCount] -= qhat * vn
+        limb_t carry = 0, borrow = 0;
+        for (size_t i = 0; i <= vCount; i++)
+        {
+            dlimb_t partResult = i < vCount ? (dlimb_t)(limb_t)qhat * vn[i] + carry : carry;
+            limb_t subtrahend = (limb_t)partResult;
+            limb_t difference = un[i + j] - subtrahend - borrow;
+
+            borrow = (un[i + j] < subtrahend) || (un[i + j] - subtrahend < borrow);
+            un[i + j] = difference;
+            carry = (limb_t)(partResult >> 64);
+        }
+
+        // the estimate was still one too large: add vn back once
+        if (borrow)
+        {
+            qhat--;
+            un[j + vCount] += limbsAdd(un + j, un + j, vn, vCount);
+        }
+
+        quotient[j] = (limb_t)qhat;
+    }
+
+    for (size_t i = 0; i < vCount; i++)
+    {
+        remainder[i] = un[i] >> shift | (shift > 0 ? un[i + 1] << (64 - shift) : 0);
+    }
+
+    free(vn);
+    free(un);
+}
+
+/**
+ * @brief one multiplication of the divide-and-conquer: result = a * b, both with count limbs
+ *
+ */
+struct mulJob
+{
+    limb_t *result;
+    const limb_t *a;
+    const limb_t *b;
+    size_t count;
+    int depth;
+    const struct mulSettings *settings;
+    limb_t *arena;
+};
+
+static void mulNode(void *argument);
+
+/**
+ * @brief checks if the jobs at the given depth get calculated in parallel
+ *
+ * @param depth the depth of the jobs
+ * @param settings the settings of the multiplication
+ * @return true if the jobs get spawned into the pool
+ * @return false if the jobs get calculated one after another
+ */
+static bool runsParallel(int depth, const struct mulSettings *settings)
+{
+    return settings->pool != NULL && depth <= settings->parallelDepth;
+}
+
+/**
+ * @brief returns the number of limbs of the arena which a node needs for itself and all nodes below it: the node
+ *        uses 2 * count + 1 limbs (the scratch of every variant fits), and its children get the rest. Children which
+ *        run one after another share their part of the arena, parallel children get one part each
+ *
+ * @param count the number of limbs of the factors of the node
+ * @param depth the depth of the node
+ * @param settings the settings of the multiplication
+ * @return size_t the number of limbs
+ */
+static size_t arenaFor(size_t count, int depth, const struct mulSettings *settings)
+{
+    if (count <= settings->threshold || count == 1)
+        return 0;
+
+    if (count % 2 == 1)
+        return arenaFor(count - 1, depth, settings);
+
+    size_t below = arenaFor(count / 2, depth + 1, settings);
+
+    return 2 * count + 1 + (runsParallel(depth + 1, settings) ? 4 * below : below);
+}
+
+/**
+ * @brief calculates the given jobs; above the parallel depth all jobs except the first one get spawned into the
+ *        pool, the first one gets calculated by the calling thread
+ *
+ * @param jobs the jobs
+ * @param count the number of jobs
+ */
+static void runJobs(struct mulJob jobs[], int count)
+{
+    const struct mulSettings *settings = jobs[0].settings;
+
+    // the jobs are one level deeper than the calling node
+    if (!runsParallel(jobs[0].depth, settings))
+    {
+        for (int i = 0; i < count; i++)
+        {
+            mulNode(&jobs[i]);
+        }
+        return;
+    }
+
+    struct taskGroup group = {0};
+    for (int i = 1; i < count; i++)
+    {
+        poolSpawn(settings->pool, &group, mulNode, &jobs[i]);
+    }
+    mulNode(&jobs[0]);
+    poolWait(settings->pool, &group);
+}
+
+/**
+ * @brief multiplies the halves of a and b (4 products or 3 with karatsuba) and merges them; below the threshold
+ *        the product gets calculated with the schoolbook method
+ *
+ * @param argument the job (struct mulJob)
+ */
+static void mulNode(void *argument)
+{
+    struct mulJob *job = argument;
+    const struct mulSettings *settings = job->settings;
+    size_t count = job->count;
+
+    if (count <= settings->threshold || count == 1)
+    {
+        mulBasecase(job->result, job->a, count, job->b, count);
+        return;
+    }
+
+    // an odd number of limbs cannot be split into equal halves, so the most significant limbs get added afterwards
+    if (count % 2 == 1)
+    {
+        struct mulJob lower = *job;
+        lower.count = count - 1;
+
+        mulNode(&lower);
+        addLastLimbs(job->result, job->a, job->b, count);
+        return;
+    }
+
+    size_t half = count / 2;
+    limb_t *result = job->result;
+    const limb_t *al = job->a, *ah = job->a + half;
+    const limb_t *bl = job->b, *bh = job->b + half;
+    int depth = job->depth + 1;
+
+    // the merge of a node in the parallel levels uses the pool too
+    struct pool *pool = runsParallel(job->depth, settings) ? settings->pool : NULL;
+
+    // the scratch of this node is at the beginning of its arena, the parts of the children follow
+    limb_t *scratch = job->arena;
+    limb_t *arenas[4];
+    size_t below = runsParallel(depth, settings) ? arenaFor(half, depth, settings) : 0;
+    for (int i = 0; i < 4; i++)
+    {
+        arenas[i] = job->arena + 2 * count + 1 + i * below;
+    }
+
+    if (settings->karatsuba)
+    {
+        // sA (half), sB (half) and sA*sB (count + 1 because the middle part gets calculated in place)
+        limb_t *sumA = scratch, *sumB = scratch + half, *middle = scratch + 2 * half;
+
+        limb_t carryA = limbsAdd(sumA, al, ah, half);
+        limb_t carryB = carryA;
+
+        // for a square the middle product is a square too: (Al+Ah)^2
+        if (job->a == job->b)
+            sumB = sumA;
+        else
+            carryB = limbsAdd(sumB, bl, bh, half);
+
+        // Al*Bl and Ah*Bh get written directly to the result
+        struct mulJob jobs[3] = {
+            {result, al, bl, half, depth, settings, arenas[0]},
+            {result + count, ah, bh, half, depth, settings, arenas[1]},
+            {middle, sumA, sumB, half, depth, settings, arenas[2]}};
+        runJobs(jobs, 3);
+
+        mergeKaratsuba(result, middle, sumA, sumB, carryA, carryB, count, pool);
+    }
+    else if (job->a == job->b)
+    {
+        // Al^2 and Ah^2 get written directly to the result, the cross product Ah*Al gets added twice afterwards
+        struct mulJob jobs[3] = {
+            {result, al, al, half, depth, settings, arenas[0]},
+            {result + count, ah, ah, half, depth, settings, arenas[1]},
+            {scratch, ah, al, half, depth, settings, arenas[2]}};
+        runJobs(jobs, 3);
+
+        mergeSquare(result, scratch, count, pool);
+    }
+    else
+    {
+        // Al*Bl and Ah*Bh get written directly to the result, Ah*Bl and Al*Bh get added afterwards
+        struct mulJob jobs[4] = {
+            {result, al, bl, half, depth, settings, arenas[0]},
+            {result + count, ah, bh, half, depth, settings, arenas[1]},
+            {scratch, ah, bl, half, depth, settings, arenas[2]},
+            {scratch + count, al, bh, half, depth, settings, arenas[3]}};
+        runJobs(jobs, 4);
+
+        mergeProducts(result, scratch, count, pool);
+    }
+}
+
+/**
+ * @brief multiplies a and b with divide-and-conquer (the same splitting as the fork mode of intmul); the upper
+ *        levels of the recursion get calculated in parallel on the pool of the settings. Above the ntt threshold
+ *        the product gets calculated with the number-theoretic transform instead
+ *
+ * @param result the array where the product gets written into (2 * count limbs; must not overlap a or b)
+ * @param a the first factor
+ * @param b the second factor
+ * @param count the number of limbs of a and b
+ * @param settings the settings of the multiplication
+ */
+void mulSplit(limb_t result[], const limb_t a[], const limb_t b[], size_t count, const struct mulSettings *settings)
+{
+    // very large factors get multiplied as a whole with the transform instead of splitting them
+    if (settings->nttThreshold > 0 && count >= settings->nttThreshold && nttFits(count, count))
+    {
+        mulNtt(result, a, count, b, count, settings->pool);
+        return;
+    }
+
+    // the scratch of all nodes gets allocated at once
+    size_t arenaCount = arenaFor(count, 0, settings);
+    struct mulJob job = {result, a, b, count, 0, settings, arenaCount > 0 ? limbsAllocate(arenaCount) : NULL};
+
+    mulNode(&job);
+
+    free(job.arena);
+}
+
+/**
+ * @brief multiplies a and b with different numbers of limbs without filling up the shorter one: the longer factor
+ *        gets split into chunks with the length of the shorter one, every chunk gets multiplied with the shorter
+ *        factor by the given balanced multiplication and the partial products get added shifted by the chunk offset
+ *        (the last, shorter chunk gets multiplied the same way with the factors swapped)
+ *
+ * @param result the array where the product gets written into (aCount + bCount limbs; must not overlap a or b)
+ * @param a the first factor
+ * @param aCount the number of limbs of a
+ * @param b the second factor
+ * @param bCount the number of limbs of b
+ * @param threshold the number of limbs of the shorter factor up to which the schoolbook method gets used
+ * @param multiply the balanced multiplication of two factors with the same number of limbs
+ * @param context the context of the balanced multiplication
+ */
+void mulUnbalanced(limb_t result[], const limb_t a[], size_t aCount, const limb_t b[], size_t bCount,
+                   size_t threshold, balancedMul multiply, void *context)
+{
+    if (aCount < bCount)
+    {
+        mulUnbalanced(result, b, bCount, a, aCount, threshold, multiply, context);
+        return;
+    }
+
+    // the schoolbook method does not need equal lengths
+    if (bCount <= threshold)
+    {
+        mulBasecase(result, a, aCount, b, bCount);
+        return;
+    }
+
+    if (aCount == bCount)
+    {
+        multiply(result, a, b, bCount, context);
+        return;
+    }
+
+    limb_t *partial = limbsAllocate(2 * bCount);
+
+    for (size_t i = 0; i < aCount + bCount; i++)
+    {
+        result[i] = 0;
+    }
+
+    for (size_t offset = 0; offset < aCount; offset += bCount)
+    {
+        size_t chunk = aCount - offset < bCount ? aCount - offset : bCount;
+
+        if (chunk == bCount)
+            multiply(partial, a + offset, b, bCount, context);
+        else
+            mulUnbalanced(partial, b, bCount, a + offset, chunk, threshold, multiply, context);
+
+        limbsAddTo(result + offset, aCount + bCount - offset, partial, chunk + bCount);
+    }
+
+    free(partial);
+}
+
+/**
+ * @brief multiplies two factors with the same number of limbs with mulSplit (balanced multiplication for
+ *        mulUnbalanced)
+ *
+ * @param result the array where the product gets written into (2 * count limbs)
+ * @param a the first factor
+ * @param b the second factor
+ * @param count the number of limbs of a and b
+ * @param context the settings of the multiplication (struct mulSettings)
+ */
+static void mulSplitBalanced(limb_t result[], const limb_t a[], const limb_t b[], size_t count, void *context)
+{
+    mulSplit(result, a, b, count, context);
+}
+
+/**
+ * @brief multiplies a and b with any numbers of limbs with the divide-and-conquer of the settings
+ *
+ * @param result the array where the product gets written into (aCount + bCount limbs; must not overlap a or b)
+ * @param a the first factor
+ * @param aCount the number of limbs of a
+ * @param b the second factor
+ * @param bCount the number of limbs of b
+ * @param settings the settings of the multiplication
+ */
+void mulWithSettings(limb_t result[], const limb_t a[], size_t aCount, const limb_t b[], size_t bCount,
+                     const struct mulSettings *settings)
+{
+    mulUnbalanced(result, a, aCount, b, bCount, settings->threshold, mulSplitBalanced, (void *)settings);
+}
+
+/**
+ * @brief compares a with B^exponent
+ *
+ * @param a the number (count > exponent)
+ * @param count the number of limbs of a
+ * @param exponent the exponent of the power of B
+ * @return int a negative value if a < B^exponent, 0 if they are equal and a positive value if a > B^exponent
+ */
+static int compareToPower(const limb_t a[], size_t count, size_t exponent)
+{
+    for (size_t i = count; i-- > exponent + 1;)
+    {
+        if (a[i] != 0)
+            return 1;
+    }
+
+    if (a[exponent] != 1)
+        return a[exponent] > 1 ? 1 : -1;
+
+    for (size_t i = 0; i < exponent; i++)
+    {
+        if (a[i] != 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief calculates mu = floor(B^(2 * count) / m) with newton's method: the reciprocal of the upper half of m
+ *        (calculated recursively) is already correct in about half of the limbs, one newton step
+ *        y + y * (B^(2 * count) - m * y) / B^(2 * count) doubles the number of correct limbs and the last few units
+ *        get corrected exactly. Small moduli get divided with the schoolbook method
+ *
+ * @param mu the array where the reciprocal gets written into (count + 2 limbs)
+ * @param m the divisor (the most significant limb must not be 0)
+ * @param count the number of limbs of m
+ * @param settings the settings of the multiplications
+ */
+void limbsReciprocal(limb_t mu[], const limb_t m[], size_t count, const struct mulSettings *settings)
+{
+    const limb_t one = 1;
+
+    if (count <= RECIPROCAL_THRESHOLD)
+    {
+        limb_t *power = limbsAllocate(3 * count + 1);
+        limb_t *remainder = power + 2 * count + 1;
+
+        memset(power, 0, 2 * count * sizeof(limb_t));
+        power[2 * count] = 1;
+        limbsDivRem(mu, remainder, power, 2 * count + 1, m, count);
+
+        free(power);
+        return;
+    }
+
+    // y = floor(B^(2 * h) / mh) * B^low with the upper h limbs mh of m
+    size_t h = count / 2 + 2;
+    size_t low = count - h;
+    limb_t *y = mu;
+
+    memset(y, 0, low * sizeof(limb_t));
+    limbsReciprocal(y + low, m + low, h, settings);
+
+    // only the upper h + 2 limbs of y are not 0 yet, the products of the newton step get calculated without the
+    // lower limbs
+    size_t productCount = 2 * count + 2;
+    size_t highCount = h + 2;
+    limb_t *product = limbsAllocate(3 * productCount + highCount);
+    limb_t *error = product + productCount;
+    limb_t *correction = error + productCount;
+
+    // the error B^(2 * count) - m * y can be negative, then its absolute value gets used
+    memset(product, 0, low * sizeof(limb_t));
+    mulWithSettings(product + low, m, count, y + low, highCount, settings);
+    int sign = compareToPower(product, productCount, 2 * count);
+    bool negative = sign > 0;
+
+    memcpy(error, product, productCount * sizeof(limb_t));
+    if (negative)
+    {
+        limbsSubFrom(error + 2 * count, 2, &one, 1);
+    }
+    else
+    {
+        for (size_t i = 0; i < 2 * count; i++)
+        {
+            error[i] = ~error[i];
+        }
+        limbsAddTo(error, productCount, &one, 1);
+    }
+
+    size_t errorCount = productCount;
+    while (errorCount > 1 && error[errorCount - 1] == 0)
+    {
+        errorCount--;
+    }
+
+    // y +- floor(y * |error| / B^(2 * count)), nothing to correct if m * y = B^(2 * count)
+    size_t correctionCount = highCount + errorCount;
+    size_t shift = 2 * count - low;
+    if (sign != 0 && correctionCount > shift)
+    {
+        mulWithSettings(correction, y + low, highCount, error, errorCount, settings);
+
+        size_t shiftedCount = correctionCount - shift;
+        if (shiftedCount > count + 2)
+            shiftedCount = count + 2;
+
+        if (negative)
+            limbsSubFrom(y, count + 2, correction + shift, shiftedCount);
+        else
+            limbsAddTo(y, count + 2, correction + shift, shiftedCount);
+    }
+
+    // y is off by only a few units now: mu is the largest y with m * y <= B^(2 * count)
+    mulWithSettings(product, m, count, y, count + 2, settings);
+    while (compareToPower(product, productCount, 2 * count) > 0)
+    {
+        limbsSubFrom(y, count + 2, &one, 1);
+        limbsSubFrom(product, productCount, m, count);
+    }
+    while (true)
+    {
+        limbsAddTo(product, productCount, m, count);
+        if (compareToPower(product, productCount, 2 * count) > 0)
+            break;
+
+        limbsAddTo(y, count + 2, &one, 1);
+    }
+
+    free(product);
+}
+
+/**
+ * @brief divides x by m with barrett's method: q = floor(floor(x / B^(count - 1)) * mu / B^(count + 1)) is at most
+ *        2 smaller than floor(x / m), so x - q * m (calculated modulo B^(count + 1)) needs at most two more
+ *        subtractions of m
+ *
+ * @param quotient the array where the quotient gets written into (muCount limbs; NULL if only the remainder is
+ *        needed)
+ * @param remainder the array where the remainder gets written into (count + 1 limbs, the last one is 0)
+ * @param x the dividend (2 * count limbs, x < m^2)
+ * @param m the divisor (the most significant limb must not be 0)
+ * @param count the number of limbs of m
+ * @param mu the reciprocal floor(B^(2 * count) / m), see limbsReciprocal
+ * @param muCount the number of limbs of mu
+ * @param scratch space for 2 * (count + muCount) + 1 limbs
+ * @param settings the settings of the multiplications
+ */
+void limbsDivBarrett(limb_t quotient[], limb_t remainder[], const limb_t x[], const limb_t m[], size_t count,
+                     const limb_t mu[], size_t muCount, limb_t scratch[], const struct mulSettings *settings)
+{
+    const limb_t one = 1;
+    limb_t *estimate = scratch;
+    limb_t *multiple = scratch + count + 1 + muCount;
+
+    mulWithSettings(estimate, x + count - 1, count + 1, mu, muCount, settings);
+
+    const limb_t *q = estimate + count + 1;
+    mulWithSettings(multiple, q, muCount, m, count, settings);
+
+    memcpy(remainder, x, (count + 1) * sizeof(limb_t));
+    limbsSubFrom(remainder, count + 1, multiple, count + 1);
+
+    if (quotient != NULL)
+        memcpy(quotient, q, muCount * sizeof(limb_t));
+
+    while (limbsCompare(remainder, count + 1, m, count) >= 0)
+    {
+        limbsSubFrom(remainder, count + 1, m, count);
+        if (quotient != NULL)
+            limbsAddTo(quotient, muCount, &one, 1);
+    }
+}
+
+/**
+ * @brief returns the number of recursion levels which get calculated in parallel: enough levels to give every
+ *        worker about two tasks, but not more (deeper levels are too small to be worth a task)
+ *
+ * @param workers the number of workers of the pool
+ * @param children the number of products per level (4 or 3 with karatsuba)
+ * @return int the number of parallel levels
+ */
+int parallelDepthFor(int workers, int children)
+{
+    int depth = 0;
+
+    for (long tasks = 1; tasks < 2L * workers && workers > 1; tasks *= children)
+    {
+        depth++;
+    }
+
+    return depth;
+}
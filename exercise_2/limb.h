@@ -0,0 +1,98 @@
+/**
+ * @file limb.h
+ * @author Florian Fürst (12122096)
+ * @brief declares the in-process arithmetic on 64-bit limbs which is used by intmul below the fork threshold and
+ *        by the thread engine;
+ *        numbers are stored as arrays of limbs, beginning with the least significant limb
+ * @date 2022-12-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef LIMB_H
+#define LIMB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pool.h"
+
+/**
+ * @brief one limb stores 16 hexadecimal digits; a double limb is needed for the product of two limbs
+ *
+ */
+typedef uint64_t limb_t;
+__extension__ typedef unsigned __int128 dlimb_t;
+
+#define LIMB_DIGITS (16)
+
+/**
+ * @brief returns the number of limbs which are needed for the given number of hexadecimal digits
+ *
+ */
+#define LIMBS_FOR_DIGITS(digits) (((digits) + LIMB_DIGITS - 1) / LIMB_DIGITS)
+
+/**
+ * @brief number of limbs of the divisor up to which limbsReciprocal uses the schoolbook division
+ *
+ */
+#define RECIPROCAL_THRESHOLD (32)
+
+/**
+ * @brief number of limbs of one block of the parallel addition and subtraction
+ *
+ */
+#define CARRY_BLOCK (4096)
+
+/**
+ * @brief settings of the divide-and-conquer multiplication: the pool (NULL for a sequential calculation), whether
+ *        karatsuba gets used, the number of limbs up to which the schoolbook method gets used, the number of
+ *        recursion levels which get calculated in parallel and the number of limbs from which on the number-theoretic
+ *        transform gets used (0 to never use it)
+ *
+ */
+struct mulSettings
+{
+    struct pool *pool;
+    bool karatsuba;
+    size_t threshold;
+    int parallelDepth;
+    size_t nttThreshold;
+};
+
+/**
+ * @brief a multiplication of two factors with the same number of limbs (result has 2 * count limbs)
+ *
+ */
+typedef void (*balancedMul)(limb_t result[], const limb_t a[], const limb_t b[], size_t count, void *context);
+
+void sqrBasecase(limb_t result[], const limb_t a[], size_t count);
+void mulBasecase(limb_t result[], const limb_t a[], size_t aCount, const limb_t b[], size_t bCount);
+limb_t *limbsAllocate(size_t count);
+limb_t limbsAdd(limb_t r[], const limb_t a[], const limb_t b[], size_t count);
+limb_t limbsAddTo(limb_t r[], size_t rCount, const limb_t a[], size_t aCount);
+limb_t limbsSubFrom(limb_t r[], size_t rCount, const limb_t a[], size_t aCount);
+limb_t limbsAddToParallel(limb_t r[], size_t rCount, const limb_t a[], size_t aCount, struct pool *pool);
+limb_t limbsSubFromParallel(limb_t r[], size_t rCount, const limb_t a[], size_t aCount, struct pool *pool);
+limb_t addMul1(limb_t r[], const limb_t a[], size_t count, limb_t factor);
+void addLastLimbs(limb_t result[], const limb_t a[], const limb_t b[], size_t count);
+void mergeProducts(limb_t result[], const limb_t middle[], size_t count, struct pool *pool);
+void mergeSquare(limb_t result[], const limb_t middle[], size_t count, struct pool *pool);
+void mergeKaratsuba(limb_t result[], limb_t middle[], const limb_t sumA[], const limb_t sumB[],
+                    limb_t carryA, limb_t carryB, size_t count, struct pool *pool);
+int limbsCompare(const limb_t a[], size_t aCount, const limb_t b[], size_t bCount);
+void limbsDivRem(limb_t quotient[], limb_t remainder[], const limb_t u[], size_t uCount, const limb_t v[],
+                 size_t vCount);
+void mulSplit(limb_t result[], const limb_t a[], const limb_t b[], size_t count, const struct mulSettings *settings);
+void mulUnbalanced(limb_t result[], const limb_t a[], size_t aCount, const limb_t b[], size_t bCount,
+                   size_t threshold, balancedMul multiply, void *context);
+void mulWithSettings(limb_t result[], const limb_t a[], size_t aCount, const limb_t b[], size_t bCount,
+                     const struct mulSettings *settings);
+void limbsReciprocal(limb_t mu[], const limb_t m[], size_t count, const struct mulSettings *settings);
+void limbsDivBarrett(limb_t quotient[], limb_t remainder[], const limb_t x[], const limb_t m[], size_t count,
+                     const limb_t mu[], size_t muCount, limb_t scratch[], const struct mulSettings *settings);
+int parallelDepthFor(int workers, int children);
+
+#endif
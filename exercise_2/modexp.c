@@ -0,0 +1,225 @@
+/**
+ * @file modexp.c
+ * @author Florian Fürst (12122096)
+ * @brief modular exponentiation a^e mod m: left-to-right sliding windows over the bits of e, every product gets
+ *        calculated with the multiplication of the thread engine and reduced with barrett's method, whose constant
+ *        gets calculated only once per modulus
+ * @date 2022-12-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "modexp.h"
+
+/**
+ * @brief calculates the constants of the modulus (the reciprocal mu with newton's method, see limbsReciprocal)
+ *
+ * @param barrett the constants which get calculated
+ * @param modulus the modulus (the most significant limb must not be 0)
+ * @param count the number of limbs of the modulus
+ * @param settings the settings of the multiplications
+ */
+void barrettInit(struct barrett *barrett, const limb_t modulus[], size_t count, struct mulSettings *settings)
+{
+    barrett->settings = settings;
+    barrett->count = count;
+    barrett->modulus = limbsAllocate(count);
+    memcpy(barrett->modulus, modulus, count * sizeof(limb_t));
+
+    // mu = floor(B^(2 * count) / m) has count + 1 limbs, or count + 2 if m is a power of B
+    barrett->mu = limbsAllocate(count + 2);
+    limbsReciprocal(barrett->mu, modulus, count, settings);
+    barrett->muCount = barrett->mu[count + 1] != 0 ? count + 2 : count + 1;
+
+    barrett->product = limbsAllocate(2 * count);
+    barrett->scratch = limbsAllocate(2 * (count + barrett->muCount) + 1);
+    barrett->remainder = limbsAllocate(count + 1);
+}
+
+/**
+ * @brief frees the constants of the modulus
+ *
+ * @param barrett the constants
+ */
+void barrettFree(struct barrett *barrett)
+{
+    free(barrett->modulus);
+    free(barrett->mu);
+    free(barrett->product);
+    free(barrett->scratch);
+    free(barrett->remainder);
+}
+
+/**
+ * @brief reduces x modulo m with barrett's method (see limbsDivBarrett)
+ *
+ * @param result the array where x mod m gets written into (count limbs; may be the same array as x)
+ * @param x the number which gets reduced (2 * count limbs, x < m^2)
+ * @param barrett the constants of the modulus
+ */
+static void barrettReduce(limb_t result[], const limb_t x[], struct barrett *barrett)
+{
+    size_t count = barrett->count;
+
+    limbsDivBarrett(NULL, barrett->remainder, x, barrett->modulus, count, barrett->mu, barrett->muCount,
+                    barrett->scratch, barrett->settings);
+
+    memcpy(result, barrett->remainder, count * sizeof(limb_t));
+}
+
+/**
+ * @brief multiplies a and b modulo m; a and b being the same array squares a with the faster square paths
+ *
+ * @param result the array where the product gets written into (count limbs; may be the same array as a or b)
+ * @param a the first factor (count limbs, less than m)
+ * @param b the second factor (count limbs, less than m)
+ * @param barrett the constants of the modulus
+ */
+static void modMul(limb_t result[], const limb_t a[], const limb_t b[], struct barrett *barrett)
+{
+    mulWithSettings(barrett->product, a, barrett->count, b, barrett->count, barrett->settings);
+    barrettReduce(result, barrett->product, barrett);
+}
+
+/**
+ * @brief reduces a number of any length modulo m
+ *
+ * @param result the array where a mod m gets written into (count limbs)
+ * @param a the number
+ * @param aCount the number of limbs of a
+ * @param barrett the constants of the modulus
+ */
+static void modReduce(limb_t result[], const limb_t a[], size_t aCount, struct barrett *barrett)
+{
+    size_t count = barrett->count;
+
+    // shorter numbers are already less than m
+    if (aCount < count)
+    {
+        memcpy(result, a, aCount * sizeof(limb_t));
+        memset(result + aCount, 0, (count - aCount) * sizeof(limb_t));
+        return;
+    }
+
+    limb_t *quotient = limbsAllocate(aCount - count + 1);
+    limbsDivRem(quotient, result, a, aCount, barrett->modulus, count);
+    free(quotient);
+}
+
+/**
+ * @brief returns bit i of the exponent
+ *
+ */
+static int bitOf(const limb_t exponent[], size_t i)
+{
+    return (exponent[i / 64] >> (i % 64)) & 1;
+}
+
+/**
+ * @brief returns the size of the sliding window for an exponent with the given number of bits; a larger window
+ *        needs fewer multiplications, but 2^(window - 1) precomputed odd powers
+ *
+ */
+static size_t windowFor(size_t bits)
+{
+    if (bits <= 8)
+        return 1;
+    if (bits <= 24)
+        return 2;
+    if (bits <= 80)
+        return 3;
+    if (bits <= 240)
+        return 4;
+    if (bits <= 672)
+        return 5;
+
+    return 6;
+}
+
+/**
+ * @brief calculates base^exponent mod m with left-to-right sliding windows: every window of the exponent begins and
+ *        ends with a set bit, so only the odd powers base^1, base^3, ..., base^(2^window - 1) get precomputed
+ *
+ * @param result the array where the power gets written into (count limbs)
+ * @param base the base (any number of limbs)
+ * @param baseCount the number of limbs of the base
+ * @param exponent the exponent
+ * @param exponentCount the number of limbs of the exponent
+ * @param barrett the constants of the modulus
+ */
+void modPow(limb_t result[], const limb_t base[], size_t baseCount, const limb_t exponent[], size_t exponentCount,
+            struct barrett *barrett)
+{
+    size_t count = barrett->count;
+    size_t bits = exponentCount * 64;
+    while (bits > 0 && !bitOf(exponent, bits - 1))
+    {
+        bits--;
+    }
+
+    // base^0 = 1 (which is 0 modulo 1)
+    memset(result, 0, count * sizeof(limb_t));
+    result[0] = count > 1 || barrett->modulus[0] != 1;
+    if (bits == 0)
+        return;
+
+    size_t window = windowFor(bits);
+    size_t powers = (size_t)1 << (window - 1);
+    limb_t *table = limbsAllocate(powers * count);
+
+    modReduce(table, base, baseCount, barrett);
+    if (powers > 1)
+    {
+        limb_t *square = limbsAllocate(count);
+        modMul(square, table, table, barrett);
+
+        for (size_t i = 1; i < powers; i++)
+        {
+            modMul(table + i * count, table + (i - 1) * count, square, barrett);
+        }
+        free(square);
+    }
+
+    bool started = false;
+    size_t i = bits;
+    while (i > 0)
+    {
+        if (!bitOf(exponent, i - 1))
+        {
+            if (started)
+                modMul(result, result, result, barrett);
+            i--;
+            continue;
+        }
+
+        // the window is bits [low, i) and ends with the lowest set bit
+        size_t low = i > window ? i - window : 0;
+        while (!bitOf(exponent, low))
+        {
+            low++;
+        }
+
+        size_t value = 0;
+        for (size_t j = i; j-- > low;)
+        {
+            value = value << 1 | bitOf(exponent, j);
+            if (started)
+                modMul(result, result, result, barrett);
+        }
+
+        if (started)
+            modMul(result, result, table + value / 2 * count, barrett);
+        else
+            memcpy(result, table + value / 2 * count, count * sizeof(limb_t));
+        started = true;
+
+        i = low;
+    }
+
+    free(table);
+}
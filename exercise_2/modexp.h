@@ -0,0 +1,41 @@
+/**
+ * @file modexp.h
+ * @author Florian Fürst (12122096)
+ * @brief declares the modular exponentiation with barrett reduction which is used by the power mode of intmul
+ * @date 2022-12-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef MODEXP_H
+#define MODEXP_H
+
+#include <stddef.h>
+
+#include "limb.h"
+
+/**
+ * @brief the precomputed constants of one modulus m with count limbs (the most significant limb is not 0):
+ *        mu = floor(B^(2 * count) / m) with muCount limbs, the settings for the multiplications and the scratch
+ *        of the reduction; the constants can be reused for any number of exponentiations with the same modulus
+ *
+ */
+struct barrett
+{
+    struct mulSettings *settings;
+    size_t count;
+    limb_t *modulus;
+    limb_t *mu;
+    size_t muCount;
+    limb_t *product;
+    limb_t *scratch;
+    limb_t *remainder;
+};
+
+void barrettInit(struct barrett *barrett, const limb_t modulus[], size_t count, struct mulSettings *settings);
+void barrettFree(struct barrett *barrett);
+void modPow(limb_t result[], const limb_t base[], size_t baseCount, const limb_t exponent[], size_t exponentCount,
+            struct barrett *barrett);
+
+#endif
@@ -0,0 +1,355 @@
+/**
+ * @file ntt.c
+ * @author Florian Fürst (12122096)
+ * @brief multiplication with number-theoretic transforms: the factors get split into 32-bit coefficients, the
+ *        cyclic convolution gets calculated modulo three primes and the exact coefficients get recovered with the
+ *        chinese remainder theorem. The butterflies of every stage get calculated in parallel on the pool
+ * @date 2022-12-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ntt.h"
+
+/**
+ * @brief the three primes (c * 2^k + 1 with primitive root 3); their product is about 2^86, which is larger than
+ *        every coefficient of the convolution (at most 2^22 * (2^32 - 1)^2)
+ *
+ */
+static const uint32_t primes[3] = {998244353, 167772161, 469762049};
+
+#define PRIMITIVE_ROOT (3)
+
+/**
+ * @brief minimal number of butterflies (or coefficients) of one parallel chunk
+ *
+ */
+#define NTT_GRAIN (4096)
+
+/**
+ * @brief context of the parallel loops of one transform
+ *
+ */
+struct nttContext
+{
+    uint32_t *values;
+    const uint32_t *other;
+    uint32_t *roots;
+    uint32_t prime;
+    uint32_t factor;
+    size_t length;
+    size_t half;
+    int bits;
+};
+
+/**
+ * @brief context of the parallel chinese remainder theorem
+ *
+ */
+struct crtContext
+{
+    uint32_t *residues[3];
+    dlimb_t *coefficients;
+    uint64_t inverse12;
+    uint64_t inverse3;
+};
+
+/**
+ * @brief calculates base^exponent modulo prime
+ *
+ * @param base the base
+ * @param exponent the exponent
+ * @param prime the modulus
+ * @return uint32_t the power
+ */
+static uint32_t powMod(uint64_t base, uint64_t exponent, uint32_t prime)
+{
+    uint64_t result = 1;
+    base %= prime;
+
+    while (exponent > 0)
+    {
+        if (exponent & 1)
+            result = result * base % prime;
+        base = base * base % prime;
+        exponent >>= 1;
+    }
+
+    return (uint32_t)result;
+}
+
+/**
+ * @brief reverses the lowest bits of the index
+ *
+ * @param index the index
+ * @param bits the number of bits
+ * @return size_t the reversed index
+ */
+static size_t reverseBits(size_t index, int bits)
+{
+    size_t reversed = 0;
+
+    for (int i = 0; i < bits; i++)
+    {
+        reversed = (reversed << 1) | ((index >> i) & 1);
+    }
+
+    return reversed;
+}
+
+/**
+ * @brief calculates the roots w^k (k in [begin, end)) of the transform, w is the root of unity of the length
+ *
+ */
+static void fillRoots(size_t begin, size_t end, void *argument)
+{
+    struct nttContext *context = argument;
+    uint64_t root = powMod(context->factor, begin, context->prime);
+
+    for (size_t k = begin; k < end; k++)
+    {
+        context->roots[k] = (uint32_t)root;
+        root = root * context->factor % context->prime;
+    }
+}
+
+/**
+ * @brief swaps the values of the indices [begin, end) with the values of their bit-reversed indices
+ *
+ */
+static void permute(size_t begin, size_t end, void *argument)
+{
+    struct nttContext *context = argument;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        size_t j = reverseBits(i, context->bits);
+        if (i < j)
+        {
+            uint32_t swap = context->values[i];
+            context->values[i] = context->values[j];
+            context->values[j] = swap;
+        }
+    }
+}
+
+/**
+ * @brief calculates the butterflies [begin, end) of one stage (butterfly t belongs to block t / half)
+ *
+ */
+static void butterflies(size_t begin, size_t end, void *argument)
+{
+    struct nttContext *context = argument;
+    uint32_t prime = context->prime;
+    size_t half = context->half;
+    size_t stride = context->length / (2 * half);
+
+    for (size_t t = begin; t < end; t++)
+    {
+        size_t j = t % half;
+        size_t i = (t - j) * 2 + j;
+
+        uint32_t u = context->values[i];
+        uint32_t v = (uint64_t)context->values[i + half] * context->roots[j * stride] % prime;
+
+        context->values[i] = u + v >= prime ? u + v - prime : u + v;
+        context->values[i + half] = u >= v ? u - v : u + prime - v;
+    }
+}
+
+/**
+ * @brief multiplies the values [begin, end) with the other values and the factor (1/length of the inverse)
+ *
+ */
+static void pointwise(size_t begin, size_t end, void *argument)
+{
+    struct nttContext *context = argument;
+    uint32_t prime = context->prime;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        uint64_t product = (uint64_t)context->values[i] * context->other[i] % prime;
+        context->values[i] = product * context->factor % prime;
+    }
+}
+
+/**
+ * @brief transforms the values in place (iterative radix-2 transform)
+ *
+ * @param values the values (length values modulo the prime)
+ * @param roots space for length / 2 roots
+ * @param length the length of the transform (a power of two)
+ * @param prime the prime
+ * @param inverse whether the inverse transform gets calculated (without the division by the length)
+ * @param pool the pool for the parallel loops
+ */
+static void transform(uint32_t values[], uint32_t roots[], size_t length, uint32_t prime, bool inverse,
+                      struct pool *pool)
+{
+    struct nttContext context = {values, NULL, roots, prime, 0, length, 0, 0};
+
+    while (((size_t)1 << context.bits) < length)
+    {
+        context.bits++;
+    }
+
+    // root of unity of the length (or its inverse)
+    context.factor = powMod(PRIMITIVE_ROOT, (prime - 1) / length, prime);
+    if (inverse)
+        context.factor = powMod(context.factor, prime - 2, prime);
+
+    poolParallelFor(pool, length / 2, NTT_GRAIN, fillRoots, &context);
+    poolParallelFor(pool, length, NTT_GRAIN, permute, &context);
+
+    for (context.half = 1; context.half < length; context.half *= 2)
+    {
+        poolParallelFor(pool, length / 2, NTT_GRAIN, butterflies, &context);
+    }
+}
+
+/**
+ * @brief recovers the coefficients [begin, end) from their residues with the chinese remainder theorem (garner)
+ *
+ */
+static void recover(size_t begin, size_t end, void *argument)
+{
+    struct crtContext *context = argument;
+    uint64_t p1 = primes[0], p2 = primes[1], p3 = primes[2];
+    uint64_t p12 = p1 * p2;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        uint64_t r1 = context->residues[0][i];
+        uint64_t r2 = context->residues[1][i];
+        uint64_t r3 = context->residues[2][i];
+
+        // x12 = r1 + p1 * v2 is the coefficient modulo p1 * p2
+        uint64_t v2 = (r2 + p2 - r1 % p2) % p2 * context->inverse12 % p2;
+        uint64_t x12 = r1 + p1 * v2;
+
+        // x = x12 + p1 * p2 * v3 is the coefficient modulo p1 * p2 * p3
+        uint64_t v3 = (r3 + p3 - x12 % p3) % p3 * context->inverse3 % p3;
+        context->coefficients[i] = x12 + (dlimb_t)p12 * v3;
+    }
+}
+
+/**
+ * @brief allocates memory and terminates the program if there is not enough memory
+ *
+ * @param size the number of bytes
+ * @return void* the memory
+ */
+static void *allocate(size_t size)
+{
+    void *memory = malloc(size);
+
+    if (memory == NULL)
+    {
+        fprintf(stderr, "Cannot allocate memory for the transform!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return memory;
+}
+
+/**
+ * @brief checks if the product of factors with the given number of limbs can be calculated with mulNtt
+ *
+ * @param aCount the number of limbs of the first factor
+ * @param bCount the number of limbs of the second factor
+ * @return true if the transform is long enough
+ * @return false otherwise
+ */
+bool nttFits(size_t aCount, size_t bCount)
+{
+    return 2 * (aCount + bCount) <= NTT_MAX_LENGTH;
+}
+
+/**
+ * @brief multiplies a and b with number-theoretic transforms (nttFits has to be true for the lengths); a square
+ *        (a and b are the same array) needs only one forward transform per prime
+ *
+ * @param result the array where the product gets written into (aCount + bCount limbs; must not overlap a or b)
+ * @param a the first factor
+ * @param aCount the number of limbs of a
+ * @param b the second factor
+ * @param bCount the number of limbs of b
+ * @param pool the pool for the parallel butterflies (may be NULL)
+ */
+void mulNtt(limb_t result[], const limb_t a[], size_t aCount, const limb_t b[], size_t bCount, struct pool *pool)
+{
+    size_t aWords = 2 * aCount, bWords = 2 * bCount;
+    size_t length = 1;
+    while (length < aWords + bWords)
+    {
+        length *= 2;
+    }
+
+    bool square = a == b && aCount == bCount;
+    uint32_t *residues[3];
+    uint32_t *other = square ? NULL : allocate(length * sizeof(uint32_t));
+    uint32_t *roots = allocate(length / 2 * sizeof(uint32_t));
+
+    for (int p = 0; p < 3; p++)
+    {
+        uint32_t prime = primes[p];
+        uint32_t *values = residues[p] = allocate(length * sizeof(uint32_t));
+
+        // 32-bit coefficients, beginning with the least significant one
+        for (size_t i = 0; i < length; i++)
+        {
+            values[i] = i < aWords ? (uint32_t)(a[i / 2] >> (32 * (i % 2))) % prime : 0;
+            if (!square)
+                other[i] = i < bWords ? (uint32_t)(b[i / 2] >> (32 * (i % 2))) % prime : 0;
+        }
+
+        transform(values, roots, length, prime, false, pool);
+        if (!square)
+            transform(other, roots, length, prime, false, pool);
+
+        struct nttContext context = {values, square ? values : other, roots, prime, powMod(length, prime - 2, prime),
+                                     length, 0, 0};
+        poolParallelFor(pool, length, NTT_GRAIN, pointwise, &context);
+
+        transform(values, roots, length, prime, true, pool);
+    }
+
+    free(other);
+    free(roots);
+
+    struct crtContext crt;
+    for (int p = 0; p < 3; p++)
+    {
+        crt.residues[p] = residues[p];
+    }
+    crt.coefficients = allocate(length * sizeof(dlimb_t));
+    crt.inverse12 = powMod(primes[0], primes[1] - 2, primes[1]);
+    crt.inverse3 = powMod((uint64_t)primes[0] * primes[1], primes[2] - 2, primes[2]);
+
+    poolParallelFor(pool, length, NTT_GRAIN, recover, &crt);
+
+    for (int p = 0; p < 3; p++)
+    {
+        free(residues[p]);
+    }
+
+    // carry propagation: coefficient i has the weight 2^(32 * i)
+    dlimb_t carry = 0;
+    for (size_t i = 0; i < aWords + bWords; i++)
+    {
+        carry += crt.coefficients[i];
+
+        if (i % 2 == 0)
+            result[i / 2] = (uint32_t)carry;
+        else
+            result[i / 2] |= (limb_t)(uint32_t)carry << 32;
+
+        carry >>= 32;
+    }
+
+    free(crt.coefficients);
+}
@@ -0,0 +1,29 @@
+/**
+ * @file ntt.h
+ * @author Florian Fürst (12122096)
+ * @brief declares the multiplication with number-theoretic transforms which is used by intmul for very large factors
+ * @date 2022-12-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef NTT_H
+#define NTT_H
+
+#include <stdbool.h>
+
+#include "limb.h"
+#include "pool.h"
+
+/**
+ * @brief max length of a transform (2^23 is the largest power of two which divides 998244353 - 1); the factors are
+ *        split into 32-bit coefficients, so both factors together can have at most 2^22 limbs
+ *
+ */
+#define NTT_MAX_LENGTH ((size_t)1 << 23)
+
+bool nttFits(size_t aCount, size_t bCount);
+void mulNtt(limb_t result[], const limb_t a[], size_t aCount, const limb_t b[], size_t bCount, struct pool *pool);
+
+#endif
@@ -0,0 +1,384 @@
+/**
+ * @file pool.c
+ * @author Florian Fürst (12122096)
+ * @brief a work-stealing thread pool: every worker has its own deque of tasks; a worker without tasks steals the
+ *        oldest task of another worker. Waiting for a group of tasks does not block, the waiting worker executes
+ *        other tasks in the meantime
+ * @date 2022-12-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+
+#include "pool.h"
+
+/**
+ * @brief argument of a started worker thread
+ *
+ */
+struct workerArgument
+{
+    struct pool *pool;
+    int index;
+};
+
+/**
+ * @brief one chunk of a parallel loop
+ *
+ */
+struct rangeTask
+{
+    void (*function)(size_t begin, size_t end, void *context);
+    size_t begin;
+    size_t end;
+    void *context;
+};
+
+/**
+ * @brief returns the index of the calling worker (0 for threads which are not part of the pool)
+ *
+ * @param pool the pool
+ * @return int the index of the worker
+ */
+static int workerIndex(struct pool *pool)
+{
+    int *index = pthread_getspecific(pool->index);
+    return index == NULL ? 0 : *index;
+}
+
+/**
+ * @brief pushes a task at the bottom of the deque
+ *
+ * @param deque the deque
+ * @param task the task which gets pushed
+ * @return true if the task was pushed
+ * @return false if the deque is full
+ */
+static bool pushBottom(struct deque *deque, struct task task)
+{
+    bool pushed = false;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom - deque->top < POOL_DEQUE_SIZE)
+    {
+        deque->tasks[deque->bottom % POOL_DEQUE_SIZE] = task;
+        deque->bottom++;
+        pushed = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    return pushed;
+}
+
+/**
+ * @brief pops the newest task from the bottom of the deque (used by the owner of the deque)
+ *
+ * @param deque the deque
+ * @param task the task where the popped task gets written into
+ * @return true if a task was popped
+ * @return false if the deque is empty
+ */
+static bool popBottom(struct deque *deque, struct task *task)
+{
+    bool popped = false;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom > deque->top)
+    {
+        deque->bottom--;
+        *task = deque->tasks[deque->bottom % POOL_DEQUE_SIZE];
+        popped = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    return popped;
+}
+
+/**
+ * @brief steals the oldest task from the top of the deque (used by all other workers)
+ *
+ * @param deque the deque
+ * @param task the task where the stolen task gets written into
+ * @return true if a task was stolen
+ * @return false if the deque is empty
+ */
+static bool stealTop(struct deque *deque, struct task *task)
+{
+    bool stolen = false;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom > deque->top)
+    {
+        *task = deque->tasks[deque->top % POOL_DEQUE_SIZE];
+        deque->top++;
+        stolen = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    return stolen;
+}
+
+/**
+ * @brief takes a task for the given worker: first from its own deque, otherwise from the deques of the others
+ *
+ * @param pool the pool
+ * @param index the index of the worker
+ * @param task the task where the found task gets written into
+ * @return true if a task was found
+ * @return false if all deques are empty
+ */
+static bool findTask(struct pool *pool, int index, struct task *task)
+{
+    bool found = popBottom(&pool->deques[index], task);
+
+    for (int i = 1; !found && i < pool->workers; i++)
+    {
+        found = stealTop(&pool->deques[(index + i) % pool->workers], task);
+    }
+
+    if (found)
+    {
+        __atomic_fetch_sub(&pool->queued, 1, __ATOMIC_SEQ_CST);
+    }
+
+    return found;
+}
+
+/**
+ * @brief executes the task and marks it as finished in its group
+ *
+ * @param task the task
+ */
+static void runTask(struct task task)
+{
+    task.function(task.argument);
+    __atomic_fetch_sub(&task.group->pending, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief the loop of one worker thread: executes tasks and sleeps as long as there are no queued tasks
+ *
+ * @param argument the worker argument (pool and index of the worker)
+ * @return void* always NULL
+ */
+static void *workerLoop(void *argument)
+{
+    struct workerArgument *worker = argument;
+    struct pool *pool = worker->pool;
+    struct task task;
+
+    pthread_setspecific(pool->index, &worker->index);
+
+    while (true)
+    {
+        if (findTask(pool, worker->index, &task))
+        {
+            runTask(task);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        while (__atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST) == 0 && !pool->shutdown)
+        {
+            pthread_cond_wait(&pool->wakeup, &pool->lock);
+        }
+        bool shutdown = pool->shutdown;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (shutdown)
+            break;
+    }
+
+    free(worker);
+    return NULL;
+}
+
+/**
+ * @brief creates a pool with the given number of workers; the calling thread is worker 0
+ *
+ * @param workers the number of workers (at least 1)
+ * @return struct pool* the pool or NULL if it cannot be created
+ */
+struct pool *poolCreate(int workers)
+{
+    struct pool *pool = calloc(1, sizeof(*pool));
+    if (pool == NULL)
+        return NULL;
+
+    pool->workers = workers;
+    pool->threads = calloc(workers, sizeof(*pool->threads));
+    pool->deques = calloc(workers, sizeof(*pool->deques));
+    if (pool->threads == NULL || pool->deques == NULL || pthread_key_create(&pool->index, NULL) != 0)
+    {
+        free(pool->threads);
+        free(pool->deques);
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wakeup, NULL);
+    for (int i = 0; i < workers; i++)
+    {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+    }
+
+    for (int i = 1; i < workers; i++)
+    {
+        struct workerArgument *worker = malloc(sizeof(*worker));
+        if (worker == NULL)
+        {
+            pool->workers = i;
+            break;
+        }
+        worker->pool = pool;
+        worker->index = i;
+
+        if (pthread_create(&pool->threads[i], NULL, workerLoop, worker) != 0)
+        {
+            free(worker);
+            pool->workers = i;
+            break;
+        }
+    }
+
+    return pool;
+}
+
+/**
+ * @brief stops all workers and frees the pool (all task groups have to be finished)
+ *
+ * @param pool the pool
+ */
+void poolDestroy(struct pool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->wakeup);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 1; i < pool->workers; i++)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    for (int i = 0; i < pool->workers; i++)
+    {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+    }
+    pthread_cond_destroy(&pool->wakeup);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_key_delete(pool->index);
+
+    free(pool->threads);
+    free(pool->deques);
+    free(pool);
+}
+
+/**
+ * @brief adds a task to the deque of the calling worker; if the deque is full, the task gets executed directly
+ *
+ * @param pool the pool
+ * @param group the group of the task
+ * @param function the function of the task
+ * @param argument the argument of the function (has to be valid until the group is finished)
+ */
+void poolSpawn(struct pool *pool, struct taskGroup *group, void (*function)(void *), void *argument)
+{
+    struct task task = {function, argument, group};
+
+    __atomic_fetch_add(&group->pending, 1, __ATOMIC_SEQ_CST);
+
+    __atomic_fetch_add(&pool->queued, 1, __ATOMIC_SEQ_CST);
+    if (!pushBottom(&pool->deques[workerIndex(pool)], task))
+    {
+        __atomic_fetch_sub(&pool->queued, 1, __ATOMIC_SEQ_CST);
+        runTask(task);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->wakeup);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief waits until all tasks of the group are finished; the calling worker executes other tasks in the meantime
+ *
+ * @param pool the pool
+ * @param group the group
+ */
+void poolWait(struct pool *pool, struct taskGroup *group)
+{
+    int index = workerIndex(pool);
+    struct task task;
+
+    while (__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) > 0)
+    {
+        if (findTask(pool, index, &task))
+        {
+            runTask(task);
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+}
+
+/**
+ * @brief executes one chunk of a parallel loop
+ *
+ * @param argument the chunk (struct rangeTask)
+ */
+static void runRange(void *argument)
+{
+    struct rangeTask *range = argument;
+    range->function(range->begin, range->end, range->context);
+}
+
+/**
+ * @brief calls the function for the indices [0, count) split into chunks which get executed in parallel; every chunk
+ *        has at least grain indices (without a pool the function gets called once for all indices)
+ *
+ * @param pool the pool (may be NULL)
+ * @param count the number of indices
+ * @param grain the minimal number of indices of one chunk
+ * @param function the function which gets called with the range [begin, end) of one chunk
+ * @param context the context of the function
+ */
+void poolParallelFor(struct pool *pool, size_t count, size_t grain,
+                     void (*function)(size_t begin, size_t end, void *context), void *context)
+{
+    // two chunks per worker, so that stealing can balance chunks of different duration
+    size_t chunks = pool == NULL ? 1 : 2 * (size_t)pool->workers;
+    if (grain > 0 && count / grain < chunks)
+        chunks = count / grain;
+
+    struct rangeTask *ranges = chunks > 1 ? malloc(chunks * sizeof(*ranges)) : NULL;
+    if (ranges == NULL)
+    {
+        function(0, count, context);
+        return;
+    }
+
+    struct taskGroup group = {0};
+    for (size_t i = 0; i < chunks; i++)
+    {
+        ranges[i].function = function;
+        ranges[i].begin = count * i / chunks;
+        ranges[i].end = count * (i + 1) / chunks;
+        ranges[i].context = context;
+
+        if (i > 0)
+            poolSpawn(pool, &group, runRange, &ranges[i]);
+    }
+    runRange(&ranges[0]);
+    poolWait(pool, &group);
+
+    free(ranges);
+}
@@ -0,0 +1,79 @@
+/**
+ * @file pool.h
+ * @author Florian Fürst (12122096)
+ * @brief declares a work-stealing thread pool which is used by the thread engine of intmul
+ * @date 2022-12-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief max number of tasks in the deque of one worker; tasks which do not fit get executed directly
+ *
+ */
+#define POOL_DEQUE_SIZE (1024)
+
+/**
+ * @brief a group of tasks; pending is the number of tasks of the group which are not finished yet
+ *
+ */
+struct taskGroup
+{
+    int pending;
+};
+
+/**
+ * @brief a task of the pool: the function which gets called with the argument, and the group of the task
+ *
+ */
+struct task
+{
+    void (*function)(void *);
+    void *argument;
+    struct taskGroup *group;
+};
+
+/**
+ * @brief the deque of one worker; the owner pushes and pops at the bottom, other workers steal from the top
+ *
+ */
+struct deque
+{
+    pthread_mutex_t lock;
+    int top;
+    int bottom;
+    struct task tasks[POOL_DEQUE_SIZE];
+};
+
+/**
+ * @brief the thread pool; worker 0 is the thread which created the pool, so it has workers - 1 threads
+ *
+ */
+struct pool
+{
+    int workers;
+    pthread_t *threads;
+    struct deque *deques;
+    pthread_key_t index;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    int queued;
+    bool shutdown;
+};
+
+struct pool *poolCreate(int workers);
+void poolDestroy(struct pool *pool);
+void poolSpawn(struct pool *pool, struct taskGroup *group, void (*function)(void *), void *argument);
+void poolWait(struct pool *pool, struct taskGroup *group);
+void poolParallelFor(struct pool *pool, size_t count, size_t grain,
+                     void (*function)(size_t begin, size_t end, void *context), void *context);
+
+#endif
@@ -0,0 +1,507 @@
+/**
+ * @file radix.c
+ * @author Florian Fürst (12122096)
+ * @brief conversion between strings of any base from 2 to 36 and limbs with divide-and-conquer: the digits get
+ *        grouped into chunks which fit into one limb, the powers P_j = base^(chunk digits * 2^j) get calculated by
+ *        repeated squaring and every level of the conversion is one multiplication (input) or one barrett division
+ *        (output) by such a power, so both directions are as fast as the multiplication (times log n) instead of
+ *        quadratic; base 16 gets converted directly by hex.c
+ * @date 2022-12-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "radix.h"
+#include "hex.h"
+
+/**
+ * @brief max number of powers (2^64 chunks are never reached)
+ *
+ */
+#define MAX_LEVELS (64)
+
+static const char radixDigitChars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+/**
+ * @brief the powers of one base: P_0 = base^digits is the largest power of the base which fits into one limb and
+ *        P_j = P_(j - 1)^2; the powers (and their reciprocals for the barrett division) get calculated only when
+ *        they are needed. The multiplications always use karatsuba, so that the conversion stays subquadratic
+ *        without it being chosen for the product
+ *
+ */
+struct radix
+{
+    int base;
+    size_t digits;
+    struct mulSettings settings;
+    int levels;
+    limb_t *power[MAX_LEVELS];
+    size_t powerCount[MAX_LEVELS];
+    limb_t *mu[MAX_LEVELS];
+    size_t muCount[MAX_LEVELS];
+};
+
+/**
+ * @brief returns the number of digits of the base which fit into one limb
+ *
+ * @param base the base (not 16)
+ * @return size_t the largest d with base^d < 2^64
+ */
+static size_t chunkDigits(int base)
+{
+    size_t digits = 0;
+
+    for (limb_t power = 1; power <= UINT64_MAX / base; power *= base)
+    {
+        digits++;
+    }
+
+    return digits;
+}
+
+/**
+ * @brief converts a char to the value of the digit
+ *
+ * @param digit the char ('0'-'9', 'a'-'z' or 'A'-'Z')
+ * @return int the value of the digit (MAX_BASE if the char is no digit)
+ */
+static int digitValue(char digit)
+{
+    if (digit >= '0' && digit <= '9')
+        return digit - '0';
+    if (digit >= 'a' && digit <= 'z')
+        return digit - 'a' + 10;
+    if (digit >= 'A' && digit <= 'Z')
+        return digit - 'A' + 10;
+    return MAX_BASE;
+}
+
+/**
+ * @brief returns the number of limbs without the leading zero limbs
+ *
+ */
+static size_t significantLimbs(const limb_t limbs[], size_t count)
+{
+    while (count > 0 && limbs[count - 1] == 0)
+    {
+        count--;
+    }
+
+    return count;
+}
+
+/**
+ * @brief initializes the powers of the base with P_0
+ *
+ * @param radix the powers
+ * @param base the base (not 16)
+ * @param settings the settings of the multiplications
+ */
+static void radixInit(struct radix *radix, int base, const struct mulSettings *settings)
+{
+    radix->base = base;
+    radix->digits = chunkDigits(base);
+    radix->settings = *settings;
+    radix->settings.karatsuba = true;
+    radix->levels = 1;
+
+    radix->power[0] = limbsAllocate(1);
+    radix->power[0][0] = 1;
+    for (size_t i = 0; i < radix->digits; i++)
+    {
+        radix->power[0][0] *= base;
+    }
+    radix->powerCount[0] = 1;
+    radix->mu[0] = NULL;
+}
+
+/**
+ * @brief frees the powers of the base
+ *
+ * @param radix the powers
+ */
+static void radixFree(struct radix *radix)
+{
+    for (int level = 0; level < radix->levels; level++)
+    {
+        free(radix->power[level]);
+        free(radix->mu[level]);
+    }
+}
+
+/**
+ * @brief returns the power P_level, all missing powers up to it get calculated by squaring
+ *
+ * @param radix the powers
+ * @param level the level of the power
+ * @return const limb_t* the power (powerCount[level] limbs, the most significant limb is not 0)
+ */
+static const limb_t *powerFor(struct radix *radix, int level)
+{
+    for (; radix->levels <= level; radix->levels++)
+    {
+        const limb_t *previous = radix->power[radix->levels - 1];
+        size_t count = radix->powerCount[radix->levels - 1];
+        limb_t *power = limbsAllocate(2 * count);
+
+        mulWithSettings(power, previous, count, previous, count, &radix->settings);
+
+        radix->power[radix->levels] = power;
+        radix->powerCount[radix->levels] = significantLimbs(power, 2 * count);
+        radix->mu[radix->levels] = NULL;
+    }
+
+    return radix->power[level];
+}
+
+/**
+ * @brief returns the reciprocal of the power P_level for the barrett division, it gets calculated once
+ *
+ * @param radix the powers (P_level has to be calculated already)
+ * @param level the level of the power
+ * @return const limb_t* the reciprocal (muCount[level] limbs)
+ */
+static const limb_t *muFor(struct radix *radix, int level)
+{
+    if (radix->mu[level] == NULL)
+    {
+        size_t count = radix->powerCount[level];
+
+        radix->mu[level] = limbsAllocate(count + 2);
+        limbsReciprocal(radix->mu[level], radix->power[level], count, &radix->settings);
+        radix->muCount[level] = radix->mu[level][count + 1] != 0 ? count + 2 : count + 1;
+    }
+
+    return radix->mu[level];
+}
+
+/**
+ * @brief converts up to RADIX_THRESHOLD chunks of digits with horner's method (one chunk after another)
+ *
+ * @param radix the powers of the base
+ * @param limbs the array where the limbs get written into (chunks limbs)
+ * @param digits the valid digits (most significant digit first)
+ * @param length the number of digits
+ * @param chunks the number of chunks of the digits (the first chunk can be shorter)
+ */
+static void fromChunks(struct radix *radix, limb_t limbs[], const char *digits, size_t length, size_t chunks)
+{
+    limb_t factor = radix->power[0][0];
+    size_t used = 0;
+    size_t first = length - (chunks - 1) * radix->digits;
+
+    for (size_t position = 0, size = first; position < length; position += size, size = radix->digits)
+    {
+        limb_t carry = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+            carry = carry * radix->base + digitValue(digits[position + i]);
+        }
+
+        // limbs = limbs * P_0 + chunk (only the first chunk can be shorter)
+        for (size_t i = 0; i < used; i++)
+        {
+            dlimb_t current = (dlimb_t)limbs[i] * factor + carry;
+            limbs[i] = (limb_t)current;
+            carry = (limb_t)(current >> 64);
+        }
+        if (carry != 0)
+            limbs[used++] = carry;
+    }
+
+    memset(limbs + used, 0, (chunks - used) * sizeof(limb_t));
+}
+
+/**
+ * @brief converts digits to limbs: the lowest 2^j chunks (the largest power of two below the number of chunks) and
+ *        the remaining higher chunks get converted recursively and the result is high * P_j + low
+ *
+ * @param radix the powers of the base
+ * @param limbs the array where the limbs get written into (chunks limbs)
+ * @param digits the valid digits (most significant digit first)
+ * @param length the number of digits
+ */
+static void fromDigits(struct radix *radix, limb_t limbs[], const char *digits, size_t length)
+{
+    size_t chunks = (length + radix->digits - 1) / radix->digits;
+
+    if (chunks <= RADIX_THRESHOLD)
+    {
+        fromChunks(radix, limbs, digits, length, chunks);
+        return;
+    }
+
+    int level = 0;
+    while (((size_t)2 << level) < chunks)
+    {
+        level++;
+    }
+    size_t lowChunks = (size_t)1 << level;
+    size_t highChunks = chunks - lowChunks;
+    size_t highLength = length - lowChunks * radix->digits;
+
+    const limb_t *power = powerFor(radix, level);
+    size_t powerCount = radix->powerCount[level];
+    limb_t *high = limbsAllocate(2 * highChunks + powerCount);
+    limb_t *product = high + highChunks;
+
+    fromDigits(radix, limbs, digits + highLength, lowChunks * radix->digits);
+    fromDigits(radix, high, digits, highLength);
+
+    // high * P_j < base^(digits of all chunks) fits into the limbs of all chunks
+    mulWithSettings(product, high, highChunks, power, powerCount, &radix->settings);
+    size_t productCount = significantLimbs(product, highChunks + powerCount);
+    if (productCount > chunks)
+        productCount = chunks;
+
+    memset(limbs + lowChunks, 0, highChunks * sizeof(limb_t));
+    limbsAddTo(limbs, chunks, product, productCount);
+
+    free(high);
+}
+
+/**
+ * @brief converts up to RADIX_THRESHOLD chunks of limbs to digits by dividing by P_0 repeatedly
+ *
+ * @param radix the powers of the base
+ * @param digits the array where the digits get written into (chunks * chunk digits chars, with leading zeros)
+ * @param limbs the limbs (less than base^(chunks * chunk digits))
+ * @param count the number of limbs
+ * @param chunks the number of chunks
+ */
+static void toChunks(struct radix *radix, char digits[], const limb_t limbs[], size_t count, size_t chunks)
+{
+    limb_t divisor = radix->power[0][0];
+    limb_t rest[RADIX_THRESHOLD];
+
+    memcpy(rest, limbs, count * sizeof(limb_t));
+
+    for (size_t chunk = chunks; chunk-- > 0;)
+    {
+        limb_t remainder = 0;
+        for (size_t i = count; i-- > 0;)
+        {
+            dlimb_t current = (dlimb_t)remainder << 64 | rest[i];
+            rest[i] = (limb_t)(current / divisor);
+            remainder = (limb_t)(current % divisor);
+        }
+        count = significantLimbs(rest, count);
+
+        char *chunkStart = digits + chunk * radix->digits;
+        for (size_t i = radix->digits; i-- > 0;)
+        {
+            chunkStart[i] = radixDigitChars[remainder % radix->base];
+            remainder /= radix->base;
+        }
+    }
+}
+
+/**
+ * @brief converts limbs less than P_level to exactly chunk digits * 2^level digits: the limbs get divided by
+ *        P_(level - 1) and the quotient and the remainder get converted recursively to the upper and the lower half
+ *
+ * @param radix the powers of the base (P_(level - 1) has to be calculated already)
+ * @param digits the array where the digits get written into (with leading zeros)
+ * @param limbs the limbs
+ * @param count the number of limbs
+ * @param level the level
+ */
+static void toDigits(struct radix *radix, char digits[], const limb_t limbs[], size_t count, int level)
+{
+    size_t chunks = (size_t)1 << level;
+
+    count = significantLimbs(limbs, count);
+    if (chunks <= RADIX_THRESHOLD)
+    {
+        toChunks(radix, digits, limbs, count, chunks);
+        return;
+    }
+
+    const limb_t *power = radix->power[level - 1];
+    size_t powerCount = radix->powerCount[level - 1];
+    size_t half = (chunks / 2) * radix->digits;
+
+    // the upper half is only zeros if the limbs are less than P_(level - 1)
+    if (limbsCompare(limbs, count, power, powerCount) < 0)
+    {
+        memset(digits, '0', half);
+        toDigits(radix, digits + half, limbs, count, level - 1);
+        return;
+    }
+
+    const limb_t *mu = muFor(radix, level - 1);
+    size_t muCount = radix->muCount[level - 1];
+    limb_t *dividend = limbsAllocate(2 * powerCount + muCount + powerCount + 1 + 2 * (powerCount + muCount) + 1);
+    limb_t *quotient = dividend + 2 * powerCount;
+    limb_t *remainder = quotient + muCount;
+    limb_t *scratch = remainder + powerCount + 1;
+
+    // the limbs are less than P_(level - 1)^2 < B^(2 * powerCount)
+    memcpy(dividend, limbs, count * sizeof(limb_t));
+    memset(dividend + count, 0, (2 * powerCount - count) * sizeof(limb_t));
+
+    limbsDivBarrett(quotient, remainder, dividend, power, powerCount, mu, muCount, scratch, &radix->settings);
+
+    // the quotient is less than P_(level - 1)
+    toDigits(radix, digits, quotient, powerCount, level - 1);
+    toDigits(radix, digits + half, remainder, powerCount, level - 1);
+
+    free(dividend);
+}
+
+/**
+ * @brief returns the index of the first char which is not a valid digit of the base
+ *
+ * @param digits the chars
+ * @param length the number of chars
+ * @param base the base
+ * @return size_t the index of the first invalid char (length if all chars are valid)
+ */
+size_t radixValidate(const char *digits, size_t length, int base)
+{
+    if (base == 16)
+        return hexValidate(digits, length);
+
+    for (size_t i = 0; i < length; i++)
+    {
+        if (digitValue(digits[i]) >= base)
+            return i;
+    }
+
+    return length;
+}
+
+/**
+ * @brief returns the number of limbs which are needed for the given number of digits
+ *
+ * @param length the number of digits
+ * @param base the base
+ * @return size_t the number of limbs
+ */
+size_t radixLimbs(size_t length, int base)
+{
+    if (base == 16)
+        return LIMBS_FOR_DIGITS(length);
+
+    size_t digits = chunkDigits(base);
+    return (length + digits - 1) / digits;
+}
+
+/**
+ * @brief returns the max number of digits of a number with the given number of limbs
+ *
+ * @param count the number of limbs
+ * @param base the base
+ * @return size_t the max number of digits (at least 1 for the number 0)
+ */
+size_t radixDigits(size_t count, int base)
+{
+    if (base == 16)
+        return count > 0 ? count * LIMB_DIGITS : 1;
+
+    // a limb is less than base^(chunk digits + 1)
+    return count > 0 ? count * (chunkDigits(base) + 1) : 1;
+}
+
+/**
+ * @brief converts a valid string of the base (most significant digit first) to limbs
+ *
+ * @param limbs the array where the limbs get written into (radixLimbs(length, base) limbs)
+ * @param digits the digits
+ * @param length the number of digits
+ * @param base the base
+ * @param settings the settings of the multiplications
+ * @return size_t the number of written limbs
+ */
+size_t limbsFromRadix(limb_t limbs[], const char *digits, size_t length, int base,
+                      const struct mulSettings *settings)
+{
+    if (base == 16)
+        return limbsFromHex(limbs, digits, length);
+
+    if (length == 0)
+        return 0;
+
+    struct radix radix;
+    radixInit(&radix, base, settings);
+
+    fromDigits(&radix, limbs, digits, length);
+
+    radixFree(&radix);
+    return radixLimbs(length, base);
+}
+
+/**
+ * @brief converts limbs to a string of the base without leading zeros (lower case, "0" for zero); the string gets
+ *        terminated with '\0'
+ *
+ * @param digits the array where the string gets written into (radixDigits(count, base) + 1 chars)
+ * @param limbs the limbs which get converted
+ * @param count the number of limbs
+ * @param base the base
+ * @param settings the settings of the multiplications
+ * @return size_t the number of digits
+ */
+size_t limbsToRadix(char digits[], const limb_t limbs[], size_t count, int base, const struct mulSettings *settings)
+{
+    count = significantLimbs(limbs, count);
+    if (count == 0)
+    {
+        strcpy(digits, "0");
+        return 1;
+    }
+
+    size_t length;
+    char *converted;
+
+    if (base == 16)
+    {
+        length = count * LIMB_DIGITS;
+        converted = digits;
+        limbsToHex(converted, limbs, count, length);
+    }
+    else
+    {
+        struct radix radix;
+        radixInit(&radix, base, settings);
+
+        // the smallest power P_level which is greater than the limbs
+        int level = 0;
+        const limb_t *power = radix.power[0];
+        while (limbsCompare(limbs, count, power, radix.powerCount[level]) >= 0)
+        {
+            power = powerFor(&radix, ++level);
+        }
+
+        length = ((size_t)1 << level) * radix.digits;
+        converted = malloc(length + 1);
+        if (converted == NULL)
+        {
+            fprintf(stderr, "Cannot allocate memory for %zu digits!\n", length);
+            exit(EXIT_FAILURE);
+        }
+
+        toDigits(&radix, converted, limbs, count, level);
+        radixFree(&radix);
+    }
+
+    size_t zeros = 0;
+    while (converted[zeros] == '0')
+    {
+        zeros++;
+    }
+
+    length -= zeros;
+    memmove(digits, converted + zeros, length);
+    digits[length] = '\0';
+
+    if (converted != digits)
+        free(converted);
+
+    return length;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file radix.h
+ * @author Florian Fürst (12122096)
+ * @brief declares the conversion between strings of any base from 2 to 36 and limbs which is used for the input and
+ *        output of intmul in other bases than 16
+ * @date 2022-12-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef RADIX_H
+#define RADIX_H
+
+#include <stddef.h>
+
+#include "limb.h"
+
+/**
+ * @brief the smallest and the largest supported base (the digits are 0-9 and a-z)
+ *
+ */
+#define MIN_BASE (2)
+#define MAX_BASE (36)
+
+/**
+ * @brief number of chunks (one limb of digits each) up to which the conversion uses the schoolbook method
+ *
+ */
+#define RADIX_THRESHOLD (16)
+
+size_t radixValidate(const char *digits, size_t length, int base);
+size_t radixLimbs(size_t length, int base);
+size_t radixDigits(size_t count, int base);
+size_t limbsFromRadix(limb_t limbs[], const char *digits, size_t length, int base,
+                      const struct mulSettings *settings);
+size_t limbsToRadix(char digits[], const limb_t limbs[], size_t count, int base, const struct mulSettings *settings);
+
+#endif
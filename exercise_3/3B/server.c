@@ -4,12 +4,19 @@
  * @brief Server program which uses HTTP 1.1. The server waits for connections from clients and transmits
  * the requested files. It is possible to specify a port on which the server shall listen for incoming connections.
  * It is also possible to specify the index filename of the file on which the server shall attempt to transmit.
+ * All connections are served by one thread with a non-blocking, edge-triggered epoll event loop; every connection
+ * has its own state (reading the request, sending the header, sending the file), so a slow client does not stall
+ * the others. With several workers, every worker process has its own listening socket on the same port
+ * (SO_REUSEPORT), its own event loop and its own CPU; the master drains the workers on SIGINT or SIGTERM.
  * @version 0.1
  * @date 2023-01-15
  *
  * @copyright Copyright (c) 2023
  *
  */
+// sched_setaffinity and the CPU_* macros
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -25,8 +32,50 @@
 #include <netdb.h>
 #include <signal.h>
 #include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <fcntl.h>
+#include <sched.h>
 #include <time.h>
 
+/**
+ * @brief max number of bytes of the request header of one connection; a longer header gets answered with 400
+ *
+ */
+#define MAX_REQUEST_SIZE (65536)
+
+/**
+ * @brief max number of events which get handled per call of epoll_wait
+ *
+ */
+#define MAX_EVENTS (256)
+
+/**
+ * @brief max number of worker processes
+ *
+ */
+#define MAX_WORKERS (1024)
+
+/**
+ * @brief max number of milliseconds for which the open connections get finished after SIGINT or SIGTERM
+ *
+ */
+#define DRAIN_TIMEOUT (5000)
+
+/**
+ * @brief max number of milliseconds a client may need to send its request header after the connection got accepted
+ *
+ */
+#define REQUEST_TIMEOUT (10000)
+
+/**
+ * @brief number of milliseconds after which accepting gets retried if it failed because of too many open files
+ *
+ */
+#define ACCEPT_RETRY (100)
+
 /**
  * @brief the program name which is used for usage and error messages
  *
@@ -47,13 +96,26 @@ volatile bool state = true;
  */
 static void handle_signal(int signal) { state = false; }
 
+/**
+ * @brief The number of open connections of the event loop
+ *
+ */
+static int open_connections = 0;
+
+/**
+ * @brief True if accepting stopped because there were no free file descriptors; the pending connections do not get
+ * notified again (edge-triggered), so accepting gets retried when connections got closed
+ *
+ */
+static bool accept_paused = false;
+
 /**
  * @brief Prints the correct usage(synopsis) of the program to stderr
  *
  */
 static void usage(void)
 {
-    fprintf(stderr, "SYNOPSIS:\n%s [-p PORT] [ -o FILE | -d DIR ] URL\n", argv_name);
+    fprintf(stderr, "SYNOPSIS:\n%s [-p PORT] [-w WORKERS] [ -o FILE | -d DIR ] URL\n", argv_name);
     exit(EXIT_FAILURE);
 }
 
@@ -61,9 +123,10 @@ static void usage(void)
  * @brief Setup of the server. Returns the given file decriptor which is needed for further implementation.
  *
  * @param port The port which is used by getaddrinfo
+ * @param reuse_port True if several sockets (one for each worker) get bound to the same port
  * @return int Returns the file descriptor of the socket
  */
-static int socket_setup(char *port)
+static int socket_setup(char *port, bool reuse_port)
 {
     struct addrinfo hints, *ai;
     memset(&hints, 0, sizeof hints);
@@ -88,13 +151,27 @@ static int socket_setup(char *port)
     int optval = 1;
     setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof optval);
 
+    // the kernel distributes the incoming connections over all sockets of the port
+    if (reuse_port && setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof optval) < 0)
+    {
+        fprintf(stderr, "%s Error, while using setsockopt(): %s\n", argv_name, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    // the event loop accepts until there is no pending connection left
+    if (fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL) | O_NONBLOCK) < 0)
+    {
+        fprintf(stderr, "%s Error, while using fcntl(): %s\n", argv_name, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
     if (bind(sockfd, ai->ai_addr, ai->ai_addrlen) < 0)
     {
         fprintf(stderr, "%s Error, while using bind(): %s\n", argv_name, strerror(errno));
         exit(EXIT_FAILURE);
     }
 
-    if (listen(sockfd, 5) < 0)
+    if (listen(sockfd, SOMAXCONN) < 0)
     {
         fprintf(stderr, "%s Error, while using listen(): %s\n", argv_name, strerror(errno));
         exit(EXIT_FAILURE);
@@ -105,17 +182,91 @@ static int socket_setup(char *port)
 }
 
 /**
- * @brief Parses the header of the client and checks if the header is valid
+ * @brief The states of a connection: the request gets read until its header is complete, then the response header
+ * and (for status code 200) the requested file get sent
+ *
+ */
+enum connection_state
+{
+    READING_REQUEST,
+    SENDING_HEADER,
+    SENDING_FILE
+};
+
+/**
+ * @brief One connection of the event loop with the buffer of its request and the progress of its response
+ *
+ */
+struct connection
+{
+    int fd;
+    enum connection_state state;
+    char *request;
+    size_t request_length;
+    size_t request_capacity;
+    size_t line_length;
+    size_t scanned;
+    char header[1024];
+    size_t header_length;
+    size_t header_sent;
+    int file_fd;
+    off_t file_offset;
+    off_t file_size;
+    long deadline;
+    struct connection *prev;
+    struct connection *next;
+};
+
+/**
+ * @brief The connections which are reading their request, ordered by their deadline (which is the same for all
+ * connections after their accept, so the order of accepting is the order of the deadlines)
+ *
+ */
+static struct connection *reading_first = NULL;
+static struct connection *reading_last = NULL;
+
+/**
+ * @brief returns the current time in milliseconds (monotonic clock)
+ *
+ * @return long The milliseconds
+ */
+static long monotonic_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Removes the connection from the list of connections which are reading their request
  *
- * @param line The current line of the header which gets read
- * @param size The size of the input buffer 'line'
- * @param sockfile The file which is used to read the content
- * @param path The path to the file which should get read from
+ * @param conn The connection
+ */
+static void stop_reading(struct connection *conn)
+{
+    if (conn->prev != NULL)
+        conn->prev->next = conn->next;
+    else
+        reading_first = conn->next;
+
+    if (conn->next != NULL)
+        conn->next->prev = conn->prev;
+    else
+        reading_last = conn->prev;
+
+    conn->prev = conn->next = NULL;
+}
+
+/**
+ * @brief Parses the request line of the client and checks if the header is valid
+ *
+ * @param line The request line (with its line break)
+ * @param path Returns the path to the file which should get read from (has to be freed)
  * @param filename The file which was eventually specified through input. Default value is "index.html"
  * @param doc_root_dir The directory which was specified through input
  * @return int Returns the appropriate status code
  */
-static int parse_and_validate_header(char *line, size_t size, FILE *sockfile, char *path, char *filename, char *doc_root_dir)
+static int parse_and_validate_header(char *line, char **path, char *filename, char *doc_root_dir)
 {
     char *temp_lineOriginal = strdup(line);
     char *temp_line = temp_lineOriginal;
@@ -123,9 +274,9 @@ static int parse_and_validate_header(char *line, size_t size, FILE *sockfile, ch
     char *rest = NULL;
     char *request_method = strtok_r(temp_line, " ", &rest); // GET
 
-    char *filepath_temp = strtok_r(NULL, " ", &rest); // /index.html or ends with '/' (dir specified)
-    if (filepath_temp == NULL)
-        filepath_temp = "";
+    char *filepath = strtok_r(NULL, " ", &rest); // /index.html or ends with '/' (dir specified)
+    if (filepath == NULL)
+        filepath = "";
 
     char *version = strtok_r(NULL, " ", &rest); // HTTP/1.1
     if (version == NULL)
@@ -133,70 +284,59 @@ static int parse_and_validate_header(char *line, size_t size, FILE *sockfile, ch
 
     char *last = strtok_r(NULL, "\r\n", &rest); // \r\n
 
-    char *filepathOriginal = strdup(filepath_temp);
-
-    char *filepath = filepathOriginal;
+    // build up path; add 'index.html' if filepath ends with '/' (dir specified)
+    size_t filepath_length = strlen(filepath);
+    bool directory = filepath_length > 0 && filepath[filepath_length - 1] == '/';
 
-    // add 'index.html' if filepath ends with '/' (dir specified)
-    if (filepath[strlen(filepath) - 1] == '/')
+    *path = malloc(strlen(doc_root_dir) + filepath_length + strlen(filename) + 1);
+    if (*path == NULL)
     {
-        strcat(filepath, filename);
+        fprintf(stderr, "%s Error, while using malloc(): %s\n", argv_name, strerror(errno));
+        exit(EXIT_FAILURE);
     }
+    strcpy(*path, doc_root_dir);
+    strcat(*path, filepath);
+    if (directory)
+        strcat(*path, filename);
 
-    // build up path
-    strcat(path, doc_root_dir);
-    strcat(path, filepath);
-
-    // read rest and ignore content
-    while (getline(&line, &size, sockfile) != -1)
-    {
-        if (strncmp(line, "\r\n", strlen("\r\n")) == 0)
-            break;
-    }
+    int status_code = 200;
 
     // check if header is invalid
-    if (request_method == NULL || filepath == NULL || version == NULL || last != NULL || strcmp(version, "HTTP/1.1\r\n"))
-    {
-        free(temp_lineOriginal);
-        if (filepath_temp != NULL)
-            free(filepathOriginal);
-
-        return 400;
-    }
+    if (request_method == NULL || last != NULL || strcmp(version, "HTTP/1.1\r\n"))
+        status_code = 400;
     // check if different request method
-    if (strcmp(request_method, "GET") != 0)
-    {
-        free(temp_lineOriginal);
-        free(filepathOriginal);
-        return 501;
-    }
+    else if (strcmp(request_method, "GET") != 0)
+        status_code = 501;
 
     free(temp_lineOriginal);
-    free(filepathOriginal);
-    return 200;
+    return status_code;
 }
 
 /**
- * @brief Builds up and writes the header, checks the appropriate extension of the file
- *  and writes the content to the wanted file
+ * @brief Builds up the header of the response, checks the appropriate extension of the file
  *
- * @param sockfile The file which is used to read the content
- * @param file_transmit The file which gets written to
+ * @param conn The connection whose header gets built
  * @param path The path to the wanted file
  * @param status_code The status code which is included in the header
  */
-static void write_to_transmit(FILE *sockfile, FILE *file_transmit, char *path, int status_code)
+static void build_header(struct connection *conn, char *path, int status_code)
 {
-    // get size of file with stat
-    struct stat attribute;
-    int length, state;
-    if ((state = stat(path, &attribute)) == 0)
-    {
-        length = attribute.st_size;
-    }
-    else
+    size_t size = sizeof(conn->header);
+
+    if (status_code != 200)
     {
-        length = -1;
+        //set message based on status code
+        char *message = "";
+        if (status_code == 400)
+            message = "Bad Request";
+        else if (status_code == 404)
+            message = "Not Found";
+        else if (status_code == 501)
+            message = "Not Implemented";
+
+        conn->header_length =
+            snprintf(conn->header, size, "HTTP/1.1 %d %s\r\nConnection: close\r\n\r\n", status_code, message);
+        return;
     }
 
     // get date and time
@@ -232,20 +372,631 @@ static void write_to_transmit(FILE *sockfile, FILE *file_transmit, char *path, i
         }
     }
 
-    if (fprintf(sockfile, "HTTP/1.1 %d %s\r\nDate: %s\r\n%sContent-Length: %d\r\nConnection: close\r\n\r\n",
-                status_code, message, date_and_time, type, length) < 0)
-        fprintf(stderr, "%s Error, while using fprintf(): %s\n", argv_name, strerror(errno));
+    conn->header_length =
+        snprintf(conn->header, size, "HTTP/1.1 %d %s\r\nDate: %s\r\n%sContent-Length: %lld\r\nConnection: close\r\n\r\n",
+                 status_code, message, date_and_time, type, (long long)conn->file_size);
+}
+
+/**
+ * @brief Determines the status code of the complete request, opens the requested file and builds the header;
+ * the connection continues with sending the header
+ *
+ * @param conn The connection
+ * @param filename The index filename
+ * @param doc_root_dir The document root directory
+ * @param too_long True if the request header did not fit into MAX_REQUEST_SIZE
+ */
+static void prepare_response(struct connection *conn, char *filename, char *doc_root_dir, bool too_long)
+{
+    char *path = NULL;
+    int status_code = 400;
+
+    if (!too_long)
+    {
+        // the request line ends at its line break (or at the end of the request if the client closed before)
+        char saved = conn->request[conn->line_length];
+        conn->request[conn->line_length] = '\0';
+        status_code = parse_and_validate_header(conn->request, &path, filename, doc_root_dir);
+        conn->request[conn->line_length] = saved;
+    }
+
+    // set status code to 404 if server cannot open the resulting filepath (or it is no regular file)
+    if (status_code == 200)
+    {
+        struct stat attribute;
+        // non-blocking, so that a FIFO does not block the event loop (it gets rejected as no regular file)
+        conn->file_fd = open(path, O_RDONLY | O_NONBLOCK);
+
+        if (conn->file_fd < 0 || fstat(conn->file_fd, &attribute) < 0 || !S_ISREG(attribute.st_mode))
+            status_code = 404;
+        else
+            conn->file_size = attribute.st_size;
+    }
+
+    if (status_code != 200 && conn->file_fd >= 0)
+    {
+        close(conn->file_fd);
+        conn->file_fd = -1;
+    }
+
+    build_header(conn, path, status_code);
+    free(path);
+
+    // the request is not needed any more
+    free(conn->request);
+    conn->request = NULL;
+    stop_reading(conn);
+    conn->state = SENDING_HEADER;
+}
+
+/**
+ * @brief Checks if the request header is complete: the request line and then all lines up to an empty line
+ *
+ * @param conn The connection (line_length and scanned keep the progress of earlier calls)
+ * @return true if the empty line was received
+ * @return false if more data is needed
+ */
+static bool request_complete(struct connection *conn)
+{
+    while (conn->scanned < conn->request_length)
+    {
+        char *begin = conn->request + conn->scanned;
+        size_t remaining = conn->request_length - conn->scanned;
+
+        if (conn->line_length > 0)
+        {
+            if (remaining >= 2 && strncmp(begin, "\r\n", strlen("\r\n")) == 0)
+                return true;
+        }
+
+        char *end = memchr(begin, '\n', remaining);
+        if (end == NULL)
+            return false;
+
+        conn->scanned = end + 1 - conn->request;
+        if (conn->line_length == 0)
+            conn->line_length = conn->scanned;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Reads everything which is available on the connection until the request header is complete
+ *
+ * @param conn The connection
+ * @param filename The index filename
+ * @param doc_root_dir The document root directory
+ * @return true if the connection is still open
+ * @return false if the connection has to be closed (error, or the client closed it without a request)
+ */
+static bool read_request(struct connection *conn, char *filename, char *doc_root_dir)
+{
+    while (conn->state == READING_REQUEST)
+    {
+        if (conn->request_length == conn->request_capacity)
+        {
+            if (conn->request_capacity == MAX_REQUEST_SIZE)
+            {
+                prepare_response(conn, filename, doc_root_dir, true);
+                break;
+            }
+
+            size_t capacity = conn->request_capacity > 0 ? 2 * conn->request_capacity : 1024;
+            char *request = realloc(conn->request, capacity + 1);
+            if (request == NULL)
+            {
+                fprintf(stderr, "%s Error, while using realloc(): %s\n", argv_name, strerror(errno));
+                return false;
+            }
+            conn->request = request;
+            conn->request_capacity = capacity;
+        }
+
+        ssize_t received = read(conn->fd, conn->request + conn->request_length,
+                                conn->request_capacity - conn->request_length);
+        if (received < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+
+            fprintf(stderr, "%s Error, while using read(): %s\n", argv_name, strerror(errno));
+            return false;
+        }
+
+        // the client closed its side: the request is what was received so far
+        if (received == 0)
+        {
+            if (conn->request_length == 0)
+                return false;
+
+            if (conn->line_length == 0)
+                conn->line_length = conn->request_length;
+            prepare_response(conn, filename, doc_root_dir, false);
+            break;
+        }
+
+        conn->request_length += received;
+        if (request_complete(conn))
+            prepare_response(conn, filename, doc_root_dir, false);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Sends as much of the response as the connection accepts
+ *
+ * @param conn The connection
+ * @return true if the response is not sent completely yet
+ * @return false if the connection has to be closed (response sent or error)
+ */
+static bool send_response(struct connection *conn)
+{
+    while (conn->state == SENDING_HEADER)
+    {
+        ssize_t sent = send(conn->fd, conn->header + conn->header_sent, conn->header_length - conn->header_sent,
+                            MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
 
-    fflush(file_transmit);
+            fprintf(stderr, "%s Error, while using send(): %s\n", argv_name, strerror(errno));
+            return false;
+        }
 
-    uint8_t buf[1024];
-    size_t read = 0;
+        conn->header_sent += sent;
+        if (conn->header_sent == conn->header_length)
+        {
+            if (conn->file_fd < 0)
+                return false;
+            conn->state = SENDING_FILE;
+        }
+    }
 
-    while ((read = fread(buf, sizeof(uint8_t), 1024, file_transmit)) != 0)
+    while (conn->file_offset < conn->file_size)
     {
-        fwrite(buf, sizeof(uint8_t), read, sockfile);
+        ssize_t sent = sendfile(conn->fd, conn->file_fd, &conn->file_offset, conn->file_size - conn->file_offset);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+
+            fprintf(stderr, "%s Error, while using sendfile(): %s\n", argv_name, strerror(errno));
+            return false;
+        }
+
+        // the file got shorter since its size was read
+        if (sent == 0)
+            break;
     }
-    fflush(sockfile);
+
+    return false;
+}
+
+/**
+ * @brief Closes the connection and frees its state
+ *
+ * @param conn The connection
+ */
+static void close_connection(struct connection *conn)
+{
+    // closing the socket removes it from the epoll instance too
+    close(conn->fd);
+    open_connections--;
+    if (conn->state == READING_REQUEST)
+        stop_reading(conn);
+    if (conn->file_fd >= 0)
+        close(conn->file_fd);
+    free(conn->request);
+    free(conn);
+}
+
+/**
+ * @brief Accepts all pending connections and adds them to the event loop; if there are no free file descriptors,
+ * accepting gets paused till connections got closed
+ *
+ * @param epfd The epoll instance
+ * @param sockfd The listening socket
+ */
+static void accept_connections(int epfd, int sockfd)
+{
+    while (true)
+    {
+        int connfd = accept(sockfd, NULL, NULL);
+
+        if (connfd < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            bool exhausted = errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM;
+            if (exhausted && !accept_paused)
+                fprintf(stderr, "%s Error, while using accept(): %s\n", argv_name, strerror(errno));
+            else if (!exhausted && errno != EAGAIN && errno != EWOULDBLOCK)
+                fprintf(stderr, "%s Error, while using accept(): %s\n", argv_name, strerror(errno));
+
+            accept_paused = exhausted;
+            return;
+        }
+        accept_paused = false;
+
+        struct connection *conn = calloc(1, sizeof(*conn));
+        if (conn == NULL || fcntl(connfd, F_SETFL, fcntl(connfd, F_GETFL) | O_NONBLOCK) < 0)
+        {
+            fprintf(stderr, "%s Error while setting up connection: %s\n", argv_name, strerror(errno));
+            free(conn);
+            close(connfd);
+            continue;
+        }
+        conn->fd = connfd;
+        conn->file_fd = -1;
+        conn->state = READING_REQUEST;
+        open_connections++;
+
+        conn->deadline = monotonic_ms() + REQUEST_TIMEOUT;
+        conn->prev = reading_last;
+        if (reading_last != NULL)
+            reading_last->next = conn;
+        else
+            reading_first = conn;
+        reading_last = conn;
+
+        // edge-triggered: the connection gets notified once for every new data and every free space to send
+        struct epoll_event event = {.events = EPOLLIN | EPOLLOUT | EPOLLET, .data.ptr = conn};
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, connfd, &event) < 0)
+        {
+            fprintf(stderr, "%s Error, while using epoll_ctl(): %s\n", argv_name, strerror(errno));
+            close_connection(conn);
+        }
+    }
+}
+
+/**
+ * @brief Runs the state machine of a connection as far as possible without blocking
+ *
+ * @param conn The connection
+ * @param filename The index filename
+ * @param doc_root_dir The document root directory
+ */
+static void handle_connection(struct connection *conn, char *filename, char *doc_root_dir)
+{
+    bool keep = true;
+
+    if (conn->state == READING_REQUEST)
+        keep = read_request(conn, filename, doc_root_dir);
+
+    if (keep && conn->state != READING_REQUEST)
+        keep = send_response(conn);
+
+    if (!keep)
+        close_connection(conn);
+}
+
+/**
+ * @brief Closes all connections which did not send their request header till their deadline
+ *
+ * @return int The number of milliseconds till the next deadline, or -1 if no connection is reading its request
+ */
+static int expire_requests(void)
+{
+    long now = monotonic_ms();
+
+    while (reading_first != NULL && reading_first->deadline <= now)
+    {
+        close_connection(reading_first);
+    }
+
+    return reading_first != NULL ? (int)(reading_first->deadline - now) : -1;
+}
+
+/**
+ * @brief The event loop: serves all connections of the listening socket till SIGINT or SIGTERM happens; then the
+ * pending connections get accepted, the listening socket gets closed and the open connections get finished (for
+ * at most DRAIN_TIMEOUT milliseconds)
+ *
+ * @param sockfd The listening socket (non-blocking)
+ * @param filename The index filename
+ * @param doc_root_dir The document root directory
+ */
+static void serve(int sockfd, char *filename, char *doc_root_dir)
+{
+    int epfd = epoll_create1(0);
+    if (epfd < 0)
+    {
+        fprintf(stderr, "%s Error, while using epoll_create1(): %s\n", argv_name, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    // the listening socket is the only one without a connection
+    struct epoll_event event = {.events = EPOLLIN | EPOLLET, .data.ptr = NULL};
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, sockfd, &event) < 0)
+    {
+        fprintf(stderr, "%s Error, while using epoll_ctl(): %s\n", argv_name, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    // SIGINT and SIGTERM only get delivered while waiting for events, so that none gets lost between the check of
+    // 'state' and the wait
+    sigset_t blocked, waiting;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    sigaddset(&blocked, SIGTERM);
+    sigprocmask(SIG_BLOCK, &blocked, &waiting);
+    sigdelset(&waiting, SIGINT);
+    sigdelset(&waiting, SIGTERM);
+
+    struct epoll_event events[MAX_EVENTS];
+
+    //loop till SIGINT or SIGTERM happens
+    while (state)
+    {
+        // the pending connections may get the file descriptors of the closed connections now
+        if (accept_paused)
+            accept_connections(epfd, sockfd);
+
+        int timeout = expire_requests();
+        if (accept_paused && (timeout < 0 || timeout > ACCEPT_RETRY))
+            timeout = ACCEPT_RETRY;
+
+        int ready = epoll_pwait(epfd, events, MAX_EVENTS, timeout, &waiting);
+
+        if (ready < 0)
+        {
+            if (errno != EINTR)
+                fprintf(stderr, "%s Error, while using epoll_wait(): %s\n", argv_name, strerror(errno));
+            continue;
+        }
+
+        for (int i = 0; i < ready; i++)
+        {
+            if (events[i].data.ptr == NULL)
+                accept_connections(epfd, sockfd);
+            else
+                handle_connection(events[i].data.ptr, filename, doc_root_dir);
+        }
+    }
+
+    // drain: new connections get refused (or go to the other workers), the accepted ones get finished
+    accept_connections(epfd, sockfd);
+
+    // the master still holds a copy of the socket, so closing it alone would not remove it from the epoll instance
+    epoll_ctl(epfd, EPOLL_CTL_DEL, sockfd, NULL);
+    close(sockfd);
+
+    long drain_end = monotonic_ms() + DRAIN_TIMEOUT;
+
+    while (true)
+    {
+        int timeout = expire_requests();
+        long remaining = drain_end - monotonic_ms();
+        if (open_connections == 0 || remaining <= 0)
+            break;
+        if (timeout < 0 || timeout > remaining)
+            timeout = remaining;
+
+        int ready = epoll_wait(epfd, events, MAX_EVENTS, timeout);
+
+        if (ready < 0)
+        {
+            if (errno != EINTR)
+                fprintf(stderr, "%s Error, while using epoll_wait(): %s\n", argv_name, strerror(errno));
+            continue;
+        }
+
+        for (int i = 0; i < ready; i++)
+        {
+            if (events[i].data.ptr != NULL)
+                handle_connection(events[i].data.ptr, filename, doc_root_dir);
+        }
+    }
+
+    close(epfd);
+}
+
+/**
+ * @brief Pins the calling worker to one of the CPUs on which the server may run (round robin over the workers)
+ *
+ * @param index The index of the worker
+ */
+static void pin_worker(int index)
+{
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) < 0 || CPU_COUNT(&allowed) == 0)
+        return;
+
+    int target = index % CPU_COUNT(&allowed);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (!CPU_ISSET(cpu, &allowed) || target-- > 0)
+            continue;
+
+        cpu_set_t single;
+        CPU_ZERO(&single);
+        CPU_SET(cpu, &single);
+        if (sched_setaffinity(0, sizeof(single), &single) < 0)
+            fprintf(stderr, "%s Error, while using sched_setaffinity(): %s\n", argv_name, strerror(errno));
+        return;
+    }
+}
+
+/**
+ * @brief Starts worker 'index' on its listening socket; the worker closes the sockets of the other workers, pins
+ * itself to its CPU and serves till SIGTERM
+ *
+ * @param index The index of the worker
+ * @param workers The number of workers
+ * @param sockets The listening sockets of all workers
+ * @param pids The process ids of all workers; the one of the new worker gets stored
+ * @param filename The index filename
+ * @param doc_root_dir The document root directory
+ * @return true if the worker got started
+ * @return false if fork failed
+ */
+static bool start_worker(int index, int workers, int sockets[], pid_t pids[], char *filename, char *doc_root_dir)
+{
+    pids[index] = fork();
+
+    switch (pids[index])
+    {
+    case -1:
+        fprintf(stderr, "%s Cannot fork worker: %s\n", argv_name, strerror(errno));
+        return false;
+
+    // worker tasks
+    case 0:
+        // a worker does not outlive its master
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+
+        for (int j = 0; j < workers; j++)
+        {
+            if (j != index)
+                close(sockets[j]);
+        }
+        pin_worker(index);
+
+        serve(sockets[index], filename, doc_root_dir);
+        exit(EXIT_SUCCESS);
+
+    // master tasks
+    default:
+        return true;
+    }
+}
+
+/**
+ * @brief Stops all workers: the listening sockets of the master get closed (so that the kernel does not pass new
+ * connections to them any more) and the workers get SIGTERM
+ *
+ * @param workers The number of workers
+ * @param sockets The listening sockets of all workers
+ * @param pids The process ids of all workers (-1 for workers which are not running)
+ */
+static void stop_workers(int workers, int sockets[], pid_t pids[])
+{
+    for (int i = 0; i < workers; i++)
+    {
+        close(sockets[i]);
+        if (pids[i] > 0)
+            kill(pids[i], SIGTERM);
+    }
+}
+
+/**
+ * @brief The master of several workers: every worker gets its own listening socket (all bound to the port before
+ * the first fork, so that errors get reported at once), its own event loop and its own CPU. A worker which crashes
+ * gets restarted on its socket (which the master keeps open, so that its pending connections are not lost); a worker
+ * which fails with an error, or a fork which fails, stops the server. On SIGINT or SIGTERM the workers get SIGTERM
+ * and finish their connections; the master returns when all workers have exited
+ *
+ * @param workers The number of workers
+ * @param port The port
+ * @param filename The index filename
+ * @param doc_root_dir The document root directory
+ * @return true if the server got stopped by SIGINT or SIGTERM
+ * @return false if a worker could not be started or failed
+ */
+static bool run_workers(int workers, char *port, char *filename, char *doc_root_dir)
+{
+    // the master handles its signals synchronously, the workers unblock SIGINT and SIGTERM in their event loop
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &signals, NULL);
+
+    int *sockets = malloc(workers * sizeof(int));
+    pid_t *pids = malloc(workers * sizeof(pid_t));
+    if (sockets == NULL || pids == NULL)
+    {
+        fprintf(stderr, "%s Error, while using malloc(): %s\n", argv_name, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < workers; i++)
+    {
+        sockets[i] = socket_setup(port, true);
+        pids[i] = -1;
+    }
+
+    int running = 0;
+    bool failed = false;
+    for (int i = 0; i < workers && !failed; i++)
+    {
+        if (start_worker(i, workers, sockets, pids, filename, doc_root_dir))
+            running++;
+        else
+            failed = true;
+    }
+
+    bool draining = failed;
+    if (draining)
+        stop_workers(workers, sockets, pids);
+
+    while (running > 0)
+    {
+        int signal;
+        if (sigwait(&signals, &signal) != 0)
+            continue;
+
+        if ((signal == SIGINT || signal == SIGTERM) && !draining)
+        {
+            draining = true;
+            stop_workers(workers, sockets, pids);
+        }
+
+        int status;
+        pid_t pid;
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+        {
+            int index = -1;
+            for (int i = 0; i < workers; i++)
+            {
+                if (pids[i] == pid)
+                    index = i;
+            }
+            if (index < 0)
+                continue;
+
+            pids[index] = -1;
+            running--;
+
+            // a worker which exits with an error would fail again after a restart
+            bool error = WIFEXITED(status) && WEXITSTATUS(status) != EXIT_SUCCESS;
+            if (error)
+            {
+                fprintf(stderr, "%s Worker %d failed\n", argv_name, index);
+                failed = true;
+            }
+            else if (!draining)
+            {
+                fprintf(stderr, "%s Worker %d exited unexpectedly; restarting it\n", argv_name, index);
+                if (start_worker(index, workers, sockets, pids, filename, doc_root_dir))
+                    running++;
+                else
+                    failed = true;
+            }
+
+            if (failed && !draining)
+            {
+                draining = true;
+                stop_workers(workers, sockets, pids);
+            }
+        }
+    }
+
+    free(sockets);
+    free(pids);
+
+    return !failed;
 }
 
 /**
@@ -258,25 +1009,22 @@ static void write_to_transmit(FILE *sockfile, FILE *file_transmit, char *path, i
 int main(int argc, char *argv[])
 {
     argv_name = argv[0];
-    bool port_set = false, file_set = false;
+    bool port_set = false, file_set = false, workers_set = false;
 
     // default values
     char *port = "8080";
     char *filename = "index.html";
     char *doc_root_dir;
-    int status_code;
-
-    char *line = NULL;
-    size_t size = 0;
+    long workers = 1;
 
     if (argc <= 1)
     {
-        fprintf(stdout, "SYNOPSIS:\n%s [-p PORT] [ -o FILE | -d DIR ] URL\n", argv_name);
+        fprintf(stdout, "SYNOPSIS:\n%s [-p PORT] [-w WORKERS] [ -o FILE | -d DIR ] URL\n", argv_name);
         exit(EXIT_FAILURE);
     }
 
     int c;
-    while ((c = getopt(argc, argv, "p:i:")) != -1)
+    while ((c = getopt(argc, argv, "p:i:w:")) != -1)
     {
         switch (c)
         {
@@ -306,6 +1054,22 @@ int main(int argc, char *argv[])
             file_set = true;
             break;
 
+        // 0 workers: one worker for each CPU
+        case 'w':
+        {
+            if (workers_set)
+                usage();
+
+            char *end;
+            workers = strtol(optarg, &end, 10);
+            if (*end != '\0' || !isdigit(*optarg) || workers > MAX_WORKERS)
+                usage();
+            if (workers == 0)
+                workers = sysconf(_SC_NPROCESSORS_ONLN) > 0 ? sysconf(_SC_NPROCESSORS_ONLN) : 1;
+            workers_set = true;
+            break;
+        }
+
         case '?':
             usage();
             break;
@@ -328,91 +1092,25 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
-    // socket setup
-    int sockfd = socket_setup(port);
-
-    //loop till SIGINT or SIGTERM happens
-    while (state)
+    // a client which closes its connection early must not terminate the server
+    struct sigaction ignore = {.sa_handler = SIG_IGN};
+    if (sigaction(SIGPIPE, &ignore, NULL) < 0)
     {
-        int connfd = accept(sockfd, NULL, NULL);
-
-        if (connfd < 0)
-        {
-            if (errno != EINTR)
-            {
-                fprintf(stderr, "%s Error, while using accept(): %s\n", argv_name, strerror(errno));
-                continue;
-            }
-        }
-
-        // break if state is false (down)
-        if (!state)
-        {
-            break;
-        }
-        //open sockfile and check if NULL
-        FILE *sockfile = fdopen(connfd, "r+");
-        if (sockfile == NULL)
-        {
-            fprintf(stderr, "%s Error while opening file with fd: %s\n", argv_name, strerror(errno));
-            close(connfd);
-            continue;
-        }
-
-        //read sockfile
-        if (getline(&line, &size, sockfile) == -1)
-        {
-            fprintf(stderr, "%s Error, while using getline(): %s\n", argv_name, strerror(errno));
-            fclose(sockfile);
-            continue;
-        }
-
-        //make path array "long" enough
-        char path[strlen(line) + strlen(doc_root_dir) + strlen(filename)];
-        strcpy(path, "");
-
-        status_code = parse_and_validate_header(line, size, sockfile, path, filename, doc_root_dir);
-
-        FILE *file_transmit = fopen(path, "r");
+        fprintf(stderr, "%s Error while initializing signal handler: %s\n", argv_name, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
 
-        // set status code to 404 if server cannot open the resulting filepath
-        if (status_code == 200)
-        {
-            if (file_transmit == NULL)
-            {
-                status_code = 404;
-            }
-        }
+    if (workers > 1)
+    {
+        if (!run_workers(workers, port, filename, doc_root_dir))
+            exit(EXIT_FAILURE);
+        return 0;
+    }
 
-        //check if still status code 200 (or if status code got changed above to 404)
-        if (status_code == 200)
-        {
-            write_to_transmit(sockfile, file_transmit, path, status_code);
-        }
-        else
-        {
-            //set message based on status code
-            char *message = "";
-            if (status_code == 400)
-                message = "Bad Request";
-            else if (status_code == 404)
-                message = "Not Found";
-            else if (status_code == 501)
-                message = "Not Implemented";
-
-            if (fprintf(sockfile, "HTTP/1.1 %d %s\r\nConnection: close\r\n\r\n", status_code, message) < 0)
-                fprintf(stderr, "%s Error, while using fprintf(): %s\n", argv_name, strerror(errno));
-            fflush(sockfile);
-        }
+    // socket setup
+    int sockfd = socket_setup(port, false);
 
-        //cleanup
-        if (file_transmit != NULL)
-        {
-            fclose(file_transmit);
-        }
-        fclose(sockfile);
-    }
-    free(line);
+    serve(sockfd, filename, doc_root_dir);
 
     return 0;
-}
\ No newline at end of file
+}